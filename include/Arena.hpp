@@ -0,0 +1,44 @@
+#ifndef ARENA_HPP
+# define ARENA_HPP
+
+# include "Utils.hpp"
+
+// 1イテレーションの間だけ使う一時データ用のバンプアロケータ
+// - 割り当ては先頭から詰めて取るだけで、個別の解放はしない
+// - イベントループの先頭でreset()し、確保済みのチャンクはそのまま使い回す
+// - 1チャンクに収まらなかったイテレーションの後は、合計サイズの1チャンクにまとめ直す
+class Arena {
+private:
+    struct Chunk {
+        char*   data;
+        size_t  size;
+    };
+
+    std::vector<Chunk>  _chunks;
+    size_t              _current;       // 使用中のチャンク
+    size_t              _offset;        // 使用中のチャンク内の位置
+    size_t              _used;          // このイテレーションで割り当てたバイト数
+    size_t              _highWater;     // 1イテレーションで割り当てた最大バイト数
+    size_t              _reserved;      // 確保済みチャンクの合計バイト数
+
+    void    addChunk(size_t minimum);
+
+    // コピー禁止
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+public:
+    explicit Arena(size_t initialSize = ARENA_CHUNK_SIZE);
+    ~Arena();
+
+    void*   allocate(size_t size);
+    char*   copy(const char* data, size_t length);     // 終端の'\0'を付けてコピー
+    void    reset();
+
+    size_t  getUsed() const;
+    size_t  getHighWater() const;
+    size_t  getReserved() const;
+    size_t  getChunkCount() const;
+};
+
+#endif
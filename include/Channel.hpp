@@ -3,30 +3,60 @@
 
 # include "Utils.hpp"
 # include "Client.hpp"
+# include "HashMap.hpp"
+# include "MaskList.hpp"
+# include <list>
+
+// メンバーごとのモード（ビットで保持）
+enum MemberMode {
+    MEMBER_OPERATOR = 1 << 0,   // +o
+    MEMBER_VOICE    = 1 << 1    // +v
+};
+
+// チャンネル参加者（参加順のリストに保持し、Client*からの索引で直接参照する）
+struct ChannelMember {
+    Client*         client;
+    unsigned char   modes;      // MemberModeの組み合わせ
+};
+
+typedef std::list<ChannelMember> MemberList;
 
 class Channel {
 private:
     std::string _name;                          // チャンネル名
+    NameId _id;                                 // インターン済みのチャンネル名ID
+    Server* _server;                            // 所属サーバー（最後の参加者が抜けたら破棄を依頼）
     std::string _topic;                         // チャンネルトピック
     std::string _key;                           // チャンネルパスワード
-    std::vector<Client*> _clients;              // チャンネル参加者
-    std::vector<std::string> _operators;        // チャンネルオペレータのニックネーム
-    std::vector<std::string> _invitedUsers;     // 招待済みユーザーのニックネーム
+    MemberList _members;                        // チャンネル参加者（参加順、モードも保持）
+    HashMap<const Client*, MemberList::iterator> _memberIndex; // Client* -> 参加者（O(1)で参加確認/退出）
+    std::vector<std::string> _invitedUsers;     // 招待済みユーザーのニックネーム（casefold済み）
+    MaskList _bans;                             // +b
+    MaskList _exceptions;                       // +e（+bに一致しても除外）
+    MaskList _inviteExceptions;                 // +I（招待なしで+iを通過）
     bool _inviteOnly;                           // 招待のみモード
     bool _topicRestricted;                      // トピック制限モード
     size_t _userLimit;                          // ユーザー数制限
     bool _hasUserLimit;                         // ユーザー制限有無フラグ
     time_t _creationTime;                       // チャンネル作成時間
+    size_t _heapAccounted;                      // _heapTotalに計上済みのヒープ使用量
+
+    static size_t _heapTotal;                   // 全チャンネルのヒープ使用量（Channelのスロット外、参加者一覧・索引・マスクリストなど）
+
+    size_t          getHeapUsage() const;
+    void            accountMemory();
 
 public:
-    Channel(const std::string& name, Client* creator);
+    Channel(const std::string& name, NameId id, Server* server, Client* creator);
     ~Channel();
 
     // ゲッター
     std::string     getName() const;
+    NameId          getId() const;
     std::string     getTopic() const;
     std::string     getKey() const;
     std::vector<Client*> getClients() const;
+    const MemberList& getMembers() const;
     bool            isInviteOnly() const;
     bool            isTopicRestricted() const;
     bool            hasKey() const;
@@ -43,30 +73,42 @@ public:
 
     // ユーザー管理
     bool            addClient(Client* client, const std::string& key = "");
-    void            removeClient(Client* client);
-    bool            isClientInChannel(Client* client) const;
-    bool            isClientInChannel(const std::string& nickname) const;
+    void            removeClient(Client* client);   // 空になったチャンネルは破棄される
+    bool            isClientInChannel(const Client* client) const;
 
-    // オペレータ管理
-    bool            isOperator(const std::string& nickname) const;
-    void            addOperator(const std::string& nickname);
-    void            removeOperator(const std::string& nickname);
+    // メンバーモード管理（オペレータ/ボイス）
+    bool            hasMemberMode(const Client* client, unsigned char mode) const;
+    bool            setMemberMode(const Client* client, unsigned char mode, bool set);
+    bool            isOperator(const Client* client) const;
+    void            addOperator(const Client* client);
+    void            removeOperator(const Client* client);
+    std::string     getMemberPrefix(const ChannelMember& member) const;
+    std::string     getMemberPrefix(const Client* client) const;
 
     // 招待管理
     void            inviteUser(const std::string& nickname);
     bool            isInvited(const std::string& nickname) const;
     void            removeInvite(const std::string& nickname);
 
+    // マスクリスト管理（+b/+e/+I）
+    bool            isBanned(const Client* client) const;       // +bに一致し、+eに一致しない
+    bool            canJoinWithoutInvite(const Client* client) const;   // 招待済みか+Iに一致
+    bool            canSpeak(const Client* client) const;       // BAN中の一般メンバーは発言不可
+    MaskList*       getMaskList(char mode);
+    void            sendMaskList(Client* client, char mode) const;
+
     // メッセージ送信
     void            broadcastMessage(const std::string& message, Client* exclude = NULL);
+    void            broadcastMessage(const SharedMessage& message, Client* exclude = NULL);
     void            sendNames(Client* client);
 
     // モード管理
     std::string     getModes() const;
-    bool            applyMode(char mode, bool set, const std::string& param = "", Client* client = NULL);
+    bool            applyMode(char mode, bool set, const std::string& param = "", Client* client = NULL, Client* target = NULL);
 
     // ユーティリティ
     size_t          getClientCount() const;
+    static size_t   getHeapTotal();
 };
 
 #endif
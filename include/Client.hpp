@@ -2,8 +2,12 @@
 # define CLIENT_HPP
 
 # include "Utils.hpp"
+# include "TimerWheel.hpp"
+# include "SharedMessage.hpp"
+# include "NameTable.hpp"
 
 class Channel;
+class Server;
 
 enum ClientStatus {
     CONNECTING,  // 初期接続状態
@@ -11,29 +15,81 @@ enum ClientStatus {
     REGISTERED   // 登録完了
 };
 
-class Client {
+// クライアント1人あたりのメモリ使用量（ステータス表示とメモリ予算の判定用）
+struct ClientMemory {
+    size_t          object;         // Clientオブジェクト本体（固定長の受信バッファを含む）
+    size_t          recvPending;    // 受信バッファ内の未処理バイト数（objectに含まれる）
+    size_t          sendQueue;      // 未送信バイト数
+    size_t          metadata;       // 名前・離席メッセージ・参加チャンネル一覧などのヒープ領域
+
+    size_t          total() const { return object + sendQueue + metadata; }
+};
+
+class Client : public TimerHandler {
 private:
     int             _fd;            // クライアントのソケットファイルディスクリプタ
     std::string     _nickname;      // ニックネーム
+    NameId          _nickId;        // ニックネームマップ上のエントリ（未登録は0）
     std::string     _username;      // ユーザー名
     std::string     _hostname;      // ホスト名
     std::string     _realname;      // 本名
-    std::string     _buffer;        // 受信バッファ
     ClientStatus    _status;        // クライアント状態
     bool            _passAccepted;  // パスワード認証済みフラグ
-    std::vector<std::string> _channels; // 参加中のチャンネル
+    std::vector<NameId> _channels;  // 参加中のチャンネル（インターン済みID）
     bool            _operator;      // サーバーオペレータフラグ
     time_t          _lastActivity;  // 最終アクティビティ時間
+    time_t          _connectTime;   // 接続時刻
+    Timer           _idleTimer;     // 登録タイムアウト/キープアライブ
+    std::string     _pingToken;     // 応答待ちのPINGトークン（空なら待機なし）
+    time_t          _pingSentAt;    // PING送信時刻
+    unsigned long long _pingSentMs; // PING送信時刻（RTT計測用）
+    long            _lastRttMs;     // 直近のRTT（未計測は-1）
     std::string     _awayMessage;   // 離席メッセージ
     bool            _away;          // 離席フラグ
+    Server*         _server;        // 所属サーバー（I/Oエンジンの参照用）
+    std::deque<SharedMessage> _sendQueue; // 未送信の行（ループ末尾にwritevでまとめて送信、ブロードキャストは共有）
+    size_t          _sendOffset;    // 先頭行の送信済みバイト数
+    size_t          _sendQueueBytes; // キュー内の未送信バイト数
+    bool            _flushScheduled; // サーバーのフラッシュリストに登録済みか
+    bool            _disconnectPending; // 送信エラーにより切断予定
+    char            _recvBuffer[RECV_BUFFER_SIZE]; // 受信バッファ（recvが直接書き込み、行はその場で切り出す）
+    size_t          _recvStart;     // 未処理データの先頭
+    size_t          _recvEnd;       // 受信済みデータの末尾
+    size_t          _recvScan;      // 改行の探索を再開する位置
+    bool            _recvSpecial;   // 探索済みの範囲にESC/NULがあるか（除去が必要）
+    bool            _discardingLine; // 長すぎる行の残りを読み捨て中
+    bool            _sendQExceeded; // 送信キューの上限を超えて切断予定（以降の送信は捨てる）
+    time_t          _sendQAboveSince; // 送信キューがウォーターマークを超えた時刻（0は下回っている）
+    Timer           _sendQTimer;    // ウォーターマーク超過が続いた場合の停滞判定の時刻
+    unsigned long   _floodTokens;   // 残りトークン（1/1000単位、コマンドの重み x 1000 を消費）
+    unsigned long long _floodRefillMs; // 最後にトークンを補充した時刻（ミリ秒）
+    bool            _floodHeld;     // トークン不足で受信バッファの行を保留中
+    Timer           _floodTimer;    // 保留中の行を処理できるだけトークンが貯まる時刻
+    std::string     _recvBacklog;   // 受信バッファに入りきらなかったデータ（io_uringで受信済みの分、順番が来たら受信バッファへ）
+    bool            _runQueued;     // サーバーの実行待ちキューに入っているか
+    unsigned long long _runQueuedMs; // 実行待ちキューに入った時刻（待ち時間の計測用）
+    bool            _readPaused;    // メモリ逼迫のため受信を停止中
+    unsigned long   _inputScore;    // 直近の受信量（1秒ごとに半減、受信停止の対象選びに使う）
+    time_t          _inputScoreTime; // _inputScoreを最後に更新した時刻
+    size_t          _heapAccounted; // _heapTotalに計上済みのヒープ使用量
+
+    static size_t   _heapTotal;     // 全クライアントのヒープ使用量（Clientのスロット外、名前・送信キュー・取っておいた受信データなど）
+
+    size_t          filterLine(char* line, size_t length);
+    size_t          getHeapUsage() const;
+    void            accountMemory();
+    void            queueMessage(const SharedMessage& message);
+    void            pushOutput(const SharedMessage& message);
+    void            markDisconnectPending();
 
 public:
-    Client(int fd, const std::string& hostname);
+    Client(int fd, const std::string& hostname, Server* server = NULL);
     ~Client();
 
     // ゲッター
     int             getFd() const;
     std::string     getNickname() const;
+    NameId          getNickId() const;
     std::string     getUsername() const;
     std::string     getHostname() const;
     std::string     getRealname() const;
@@ -43,11 +99,12 @@ public:
     time_t          getLastActivity() const;
     bool            isAway() const;
     std::string     getAwayMessage() const;
-    std::vector<std::string> getChannels() const;
+    const std::vector<NameId>& getChannels() const;
     std::string     getPrefix() const; // nickname!username@hostname 形式
 
     // セッター
     void            setNickname(const std::string& nickname);
+    void            setNickId(NameId id);
     void            setUsername(const std::string& username);
     void            setRealname(const std::string& realname);
     void            setStatus(ClientStatus status);
@@ -57,23 +114,64 @@ public:
     void            setAway(bool away, const std::string& message = "");
 
     // チャンネル管理
-    void            addChannel(const std::string& channel);
-    void            removeChannel(const std::string& channel);
-    bool            isInChannel(const std::string& channel) const;
+    void            addChannel(const Channel* channel);
+    void            removeChannel(const Channel* channel);
+    bool            isInChannel(NameId channelId) const;
+
+    // 受信バッファ操作
+    size_t          prepareRecv(char*& space);
+    void            commitRecv(size_t length);
+    size_t          appendInput(const char* data, size_t length);
+    bool            nextLine(const char*& line, size_t& length);
+    void            deferLine(const char* line, size_t length);
+    void            stashInput(const char* data, size_t length);
+    void            refillFromBacklog();
+    bool            hasBacklog() const;
+    bool            hasRecvSpace() const;
 
-    // バッファ操作
-    void            appendToBuffer(const std::string& data);
-    std::string     getBuffer() const;
-    void            clearBuffer();
-    std::vector<std::string> getCompleteMessages();
+    // 実行待ちキュー（1回の順番で実行する行数を制限し、残りは次の順番へ）
+    bool            isRunQueued() const;
+    unsigned long long getRunQueuedMs() const;
+    void            setRunQueued(bool queued, unsigned long long nowMs);
+
+    // フラッド制御（トークンバケット）
+    bool            consumeFloodTokens(unsigned cost);
+    void            holdInput(unsigned cost);
+    void            releaseInput();
+    bool            isFloodHeld() const;
+    bool            wantsInput() const;
+    bool            isReadPaused() const;
+    void            setReadPaused(bool paused);
+    unsigned long   getInputScore() const;
 
     // メッセージ送信
     void            sendMessage(const std::string& message);
+    void            sendMessage(const SharedMessage& message);
     void            sendNumericReply(int code, const std::string& message);
+    bool            flushOutput();
+    bool            hasQueuedOutput() const;
+    size_t          getQueuedOutputSize() const;
+    ClientMemory    getMemoryUsage() const;
+    size_t          getReleasableMemory() const;
+    static size_t   getHeapTotal();
+    bool            isSendQExceeded() const;
+    time_t          getSendQAboveSince() const;
+    void            setSendQAboveSince(time_t since);
+    void            scheduleSendQCheck(unsigned long delayMs);
+    bool            isSendQCheckScheduled() const;
+    void            exceedSendQ();
+    bool            isDisconnectPending() const;
+    void            disconnect(const std::string& reason);
+    void            setFlushScheduled(bool scheduled);
 
     // ユーザー認証のための関数
     bool            isRegistered() const;
     bool            hasCompletedRegistration() const;
+
+    // タイムアウト処理/キープアライブ
+    void            onTimer(Timer& timer);
+    bool            handlePong(const std::string& token);
+    long            getLastRtt() const;
 };
 
 #endif
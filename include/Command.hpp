@@ -5,6 +5,7 @@
 # include "Client.hpp"
 # include "Channel.hpp"
 # include "Server.hpp"
+# include "Parser.hpp"
 
 class Server;
 
@@ -14,11 +15,11 @@ protected:
     Server*         _server;
     Client*         _client;
     std::string     _name;
-    std::vector<std::string> _params;
+    ParamList       _params;        // 受信した行への参照（実行中のみ有効）
     bool            _requiresRegistration;
 
 public:
-    Command(Server* server, Client* client, const std::string& name, const std::vector<std::string>& params);
+    Command(Server* server, Client* client, const std::string& name, const ParamList& params);
     virtual ~Command();
 
     virtual void execute() = 0;
@@ -29,25 +30,48 @@ public:
     std::string getName() const;
     Client* getClient() const;
     Server* getServer() const;
-    std::vector<std::string> getParams() const;
+    const ParamList& getParams() const;
 };
 
-// コマンドファクトリークラス
+// コマンドテーブルの項目（コマンドごとの実行関数と共通チェック用の情報）
+typedef void (*CommandRunner)(Server* server, Client* client, const ParamList& params);
+
+struct CommandSpec {
+    const char*     name;
+    CommandRunner   run;                    // NULLはサブコマンドで振り分け（DCC）
+    size_t          minParams;              // 最低限必要なパラメータ数
+    bool            requiresRegistration;   // 登録完了が必要か
+    unsigned        weight;                 // フラッド制御で消費するトークン（IRC_FLOOD_WEIGHTSで変更可）
+};
+
+// コマンドファクトリークラス（名前からテーブルを引いてコマンドを実行）
 class CommandFactory {
 private:
     Server* _server;
+    std::vector<unsigned> _weights;     // コマンドテーブルの順に、実際に使う重み
+
+    bool    run(const CommandSpec& spec, Client* client, const ParamList& params);
+    void    loadWeights(const char* config);
 
 public:
     CommandFactory(Server* server);
     ~CommandFactory();
 
-    Command* createCommand(Client* client, const std::string& message);
+    static const CommandSpec* findCommand(const char* name, size_t length);
+    static const CommandSpec* findDCCCommand(const char* name, size_t length);
+
+    // パースして実行（実行した場合はtrue）
+    bool    dispatch(Client* client, const char* message, size_t length);
+
+    // 行のコマンドの重み（未知のコマンドは1、行全体はパースせずコマンド名だけを見る）
+    unsigned getCost(const char* message, size_t length) const;
+    std::string describeWeights() const;
 };
 
 // 個別コマンドクラス
 class PassCommand : public Command {
 public:
-    PassCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    PassCommand(Server* server, Client* client, const ParamList& params);
     ~PassCommand();
 
     void execute();
@@ -55,7 +79,7 @@ public:
 
 class NickCommand : public Command {
 public:
-    NickCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    NickCommand(Server* server, Client* client, const ParamList& params);
     ~NickCommand();
 
     void execute();
@@ -63,7 +87,7 @@ public:
 
 class UserCommand : public Command {
 public:
-    UserCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    UserCommand(Server* server, Client* client, const ParamList& params);
     ~UserCommand();
 
     void execute();
@@ -71,7 +95,7 @@ public:
 
 class QuitCommand : public Command {
 public:
-    QuitCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    QuitCommand(Server* server, Client* client, const ParamList& params);
     ~QuitCommand();
 
     void execute();
@@ -79,7 +103,7 @@ public:
 
 class JoinCommand : public Command {
 public:
-    JoinCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    JoinCommand(Server* server, Client* client, const ParamList& params);
     ~JoinCommand();
 
     void execute();
@@ -87,7 +111,7 @@ public:
 
 class PartCommand : public Command {
 public:
-    PartCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    PartCommand(Server* server, Client* client, const ParamList& params);
     ~PartCommand();
 
     void execute();
@@ -95,7 +119,7 @@ public:
 
 class PrivmsgCommand : public Command {
 public:
-    PrivmsgCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    PrivmsgCommand(Server* server, Client* client, const ParamList& params);
     ~PrivmsgCommand();
 
     void execute();
@@ -103,7 +127,7 @@ public:
 
 class NoticeCommand : public Command {
 public:
-    NoticeCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    NoticeCommand(Server* server, Client* client, const ParamList& params);
     ~NoticeCommand();
 
     void execute();
@@ -111,7 +135,7 @@ public:
 
 class KickCommand : public Command {
 public:
-    KickCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    KickCommand(Server* server, Client* client, const ParamList& params);
     ~KickCommand();
 
     void execute();
@@ -119,7 +143,7 @@ public:
 
 class InviteCommand : public Command {
 public:
-    InviteCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    InviteCommand(Server* server, Client* client, const ParamList& params);
     ~InviteCommand();
 
     void execute();
@@ -127,7 +151,7 @@ public:
 
 class TopicCommand : public Command {
 public:
-    TopicCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    TopicCommand(Server* server, Client* client, const ParamList& params);
     ~TopicCommand();
 
     void execute();
@@ -135,7 +159,7 @@ public:
 
 class ModeCommand : public Command {
 public:
-    ModeCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    ModeCommand(Server* server, Client* client, const ParamList& params);
     ~ModeCommand();
 
     void execute();
@@ -143,7 +167,7 @@ public:
 
 class PingCommand : public Command {
 public:
-    PingCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    PingCommand(Server* server, Client* client, const ParamList& params);
     ~PingCommand();
 
     void execute();
@@ -151,7 +175,7 @@ public:
 
 class PongCommand : public Command {
 public:
-    PongCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    PongCommand(Server* server, Client* client, const ParamList& params);
     ~PongCommand();
 
     void execute();
@@ -159,7 +183,7 @@ public:
 
 class WhoCommand : public Command {
 public:
-    WhoCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    WhoCommand(Server* server, Client* client, const ParamList& params);
     ~WhoCommand();
 
     void execute();
@@ -167,7 +191,7 @@ public:
 
 class WhoisCommand : public Command {
 public:
-    WhoisCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    WhoisCommand(Server* server, Client* client, const ParamList& params);
     ~WhoisCommand();
 
     void execute();
@@ -175,7 +199,7 @@ public:
 
 class CapCommand : public Command {
 public:
-    CapCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    CapCommand(Server* server, Client* client, const ParamList& params);
     ~CapCommand();
 
     void execute();
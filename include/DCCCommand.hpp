@@ -13,7 +13,7 @@ private:
     std::string     convertIPToLong(const std::string& ip) const;
     
 public:
-    DCCSendCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    DCCSendCommand(Server* server, Client* client, const ParamList& params);
     ~DCCSendCommand();
     
     void execute();
@@ -25,7 +25,7 @@ private:
     bool            parseTransferInfo(const std::string& info, std::string& transferId);
     
 public:
-    DCCGetCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    DCCGetCommand(Server* server, Client* client, const ParamList& params);
     ~DCCGetCommand();
     
     void execute();
@@ -34,7 +34,7 @@ public:
 // DCC REJECT コマンド
 class DCCRejectCommand : public Command {
 public:
-    DCCRejectCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    DCCRejectCommand(Server* server, Client* client, const ParamList& params);
     ~DCCRejectCommand();
     
     void execute();
@@ -43,7 +43,7 @@ public:
 // DCC LIST コマンド
 class DCCListCommand : public Command {
 public:
-    DCCListCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    DCCListCommand(Server* server, Client* client, const ParamList& params);
     ~DCCListCommand();
     
     void execute();
@@ -52,7 +52,7 @@ public:
 // DCC CANCEL コマンド
 class DCCCancelCommand : public Command {
 public:
-    DCCCancelCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    DCCCancelCommand(Server* server, Client* client, const ParamList& params);
     ~DCCCancelCommand();
     
     void execute();
@@ -61,7 +61,7 @@ public:
 // DCC STATUS コマンド
 class DCCStatusCommand : public Command {
 public:
-    DCCStatusCommand(Server* server, Client* client, const std::vector<std::string>& params);
+    DCCStatusCommand(Server* server, Client* client, const ParamList& params);
     ~DCCStatusCommand();
     
     void execute();
@@ -3,13 +3,15 @@
 
 # include "Utils.hpp"
 # include "DCCTransfer.hpp"
+# include "TimerWheel.hpp"
+# include "ObjectPool.hpp"
 # include <map>
 # include <vector>
 
 class Server;
 class Client;
 
-class DCCManager {
+class DCCManager : public TimerHandler {
 private:
     // GETリクエスト情報を保持する構造体
     struct GetRequest {
@@ -20,6 +22,7 @@ private:
     };
     
     Server*                                     _server;
+    ObjectPool<DCCTransfer, 8>                  _transferPool;      // DCCTransferのスラブ（転送バッファとファイルストリームを含む）
     std::map<std::string, DCCTransfer*>        _transfers;         // 転送ID -> DCCTransfer
     std::map<int, DCCTransfer*>                _socketTransfers;   // ソケットFD -> DCCTransfer
     std::map<std::string, std::vector<std::string> > _pendingTransfers; // ニックネーム -> 転送ID
@@ -47,7 +50,7 @@ public:
     // 転送の処理
     void            processTransfers();
     void            handleTransferSocket(int socket);
-    void            checkTimeouts();
+    void            onTimer(Timer& timer);
     
     // 転送情報の取得
     DCCTransfer*    getTransfer(const std::string& transferId);
@@ -71,6 +74,7 @@ public:
     size_t          getPendingTransferCount() const;
     size_t          getCompletedTransferCount() const;
     unsigned long   getTotalBytesTransferred() const;
+    const PoolStats& getPoolStats() const;
     
     // 通知
     void            notifySendRequest(DCCTransfer* transfer);
@@ -89,6 +93,8 @@ private:
     void            addTransfer(DCCTransfer* transfer);
     void            removeTransfer(const std::string& transferId);
     void            cleanupTransfer(DCCTransfer* transfer);
+    void            refreshTransferSockets(DCCTransfer* transfer, int oldListenSocket, int oldDataSocket);
+    void            unregisterTransferSockets(DCCTransfer* transfer);
     
     // ヘルパー関数
     std::string     formatFileSize(unsigned long size) const;
@@ -2,6 +2,7 @@
 # define DCCTRANSFER_HPP
 
 # include "Utils.hpp"
+# include "TimerWheel.hpp"
 # include <fstream>
 # include <sys/stat.h>
 # include <arpa/inet.h>
@@ -39,12 +40,13 @@ private:
     std::string         _senderIP;      // 送信者IP
     time_t              _startTime;     // 転送開始時刻
     time_t              _lastActivity;  // 最終活動時刻
-    std::ifstream*      _sendFile;      // 送信用ファイルストリーム
-    std::ofstream*      _recvFile;      // 受信用ファイルストリーム
-    char*               _buffer;        // 転送バッファ
     static const size_t DCC_BUFFER_SIZE = 8192; // バッファサイズ
     static const size_t DCC_FLUSH_INTERVAL = 65536; // フラッシュ間隔（64KB）
+    std::ifstream       _sendFile;      // 送信用ファイルストリーム（転送と同じスロットに置く）
+    std::ofstream       _recvFile;      // 受信用ファイルストリーム
+    char                _buffer[DCC_BUFFER_SIZE]; // 転送バッファ
     unsigned long       _lastFlushBytes; // 最後にフラッシュした時点のバイト数
+    Timer               _timeoutTimer;  // 無通信タイムアウト（DCCManagerが管理）
 
 public:
     DCCTransfer(Client* sender, Client* receiver, const std::string& filename, 
@@ -65,6 +67,8 @@ public:
     void            setStatus(DCCTransferStatus status);
     void            updateLastActivity();
     bool            isTimeout() const;
+    time_t          getLastActivity() const;
+    Timer&          getTimeoutTimer();
     bool            isCompleted() const;
     void            cleanup();
     
@@ -0,0 +1,185 @@
+#ifndef HASHMAP_HPP
+# define HASHMAP_HPP
+
+# include "Utils.hpp"
+
+// キーのハッシュ関数（ポインタ・整数・文字列を用意、必要に応じて特殊化を追加）
+template <class K>
+struct DefaultHash;
+
+template <class T>
+struct DefaultHash<T*> {
+    size_t operator()(T* key) const {
+        // 下位ビットはアラインメントで偏るため乗算で混ぜる
+        unsigned long long value = (unsigned long long)(size_t)key;
+        return (size_t)((value * 0x9E3779B97F4A7C15ULL) >> 16);
+    }
+};
+
+template <>
+struct DefaultHash<unsigned int> {
+    size_t operator()(unsigned int key) const {
+        return (size_t)(((unsigned long long)key * 0x9E3779B97F4A7C15ULL) >> 16);
+    }
+};
+
+template <>
+struct DefaultHash<std::string> {
+    size_t operator()(const std::string& key) const {
+        // FNV-1a
+        unsigned int hash = 2166136261u;
+        for (size_t i = 0; i < key.length(); ++i) {
+            hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+// オープンアドレス法（線形探索）のハッシュテーブル
+// 容量は2のべき乗で、負荷率が3/4を超えたら2倍に拡張する
+// 削除は後続要素を詰め直す方式（墓標を残さないため探索長が伸びない）
+template <class K, class V, class H = DefaultHash<K> >
+class HashMap {
+private:
+    struct Slot {
+        K       key;
+        V       value;
+        bool    used;
+    };
+
+    std::vector<Slot>   _slots;
+    size_t              _size;
+    H                   _hash;
+
+    size_t mask() const {
+        return _slots.size() - 1;
+    }
+
+    // キーのあるスロット、なければ挿入先の空きスロット
+    size_t probe(const K& key) const {
+        size_t index = _hash(key) & mask();
+        while (_slots[index].used && !(_slots[index].key == key)) {
+            index = (index + 1) & mask();
+        }
+        return index;
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(_slots);
+        Slot empty = Slot();
+        _slots.assign(old.empty() ? 8 : old.size() * 2, empty);
+        _size = 0;
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (old[i].used) {
+                insert(old[i].key, old[i].value);
+            }
+        }
+    }
+
+public:
+    HashMap() : _size(0) {
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    void clear() {
+        _slots.clear();
+        _size = 0;
+    }
+
+    // スロット配列のバイト数（キーや値が持つヒープ領域は含まない）
+    size_t getMemoryUsage() const {
+        return _slots.capacity() * sizeof(Slot);
+    }
+
+    V* find(const K& key) {
+        if (_size == 0) {
+            return NULL;
+        }
+        size_t index = probe(key);
+        return _slots[index].used ? &_slots[index].value : NULL;
+    }
+
+    const V* find(const K& key) const {
+        if (_size == 0) {
+            return NULL;
+        }
+        size_t index = probe(key);
+        return _slots[index].used ? &_slots[index].value : NULL;
+    }
+
+    bool contains(const K& key) const {
+        return find(key) != NULL;
+    }
+
+    // 追加または上書き
+    V& insert(const K& key, const V& value) {
+        if ((_size + 1) * 4 > _slots.size() * 3) {
+            grow();
+        }
+        size_t index = probe(key);
+        if (!_slots[index].used) {
+            _slots[index].used = true;
+            _slots[index].key = key;
+            _size++;
+        }
+        _slots[index].value = value;
+        return _slots[index].value;
+    }
+
+    bool erase(const K& key) {
+        if (_size == 0) {
+            return false;
+        }
+        size_t index = probe(key);
+        if (!_slots[index].used) {
+            return false;
+        }
+
+        // 後続の要素を本来の位置に近づけるように詰め直す
+        size_t hole = index;
+        size_t next = (hole + 1) & mask();
+        while (_slots[next].used) {
+            size_t home = _hash(_slots[next].key) & mask();
+            // homeが (hole, next] の外にあれば hole へ移動できる
+            if (((next - home) & mask()) >= ((next - hole) & mask())) {
+                _slots[hole] = _slots[next];
+                hole = next;
+            }
+            next = (next + 1) & mask();
+        }
+        _slots[hole] = Slot();
+        _size--;
+        return true;
+    }
+
+    // スロット単位の走査（順序は不定）
+    size_t capacity() const {
+        return _slots.size();
+    }
+
+    bool isUsed(size_t index) const {
+        return _slots[index].used;
+    }
+
+    const K& keyAt(size_t index) const {
+        return _slots[index].key;
+    }
+
+    V& valueAt(size_t index) {
+        return _slots[index].value;
+    }
+
+    const V& valueAt(size_t index) const {
+        return _slots[index].value;
+    }
+};
+
+#endif
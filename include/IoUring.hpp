@@ -0,0 +1,134 @@
+#ifndef IOURING_HPP
+# define IOURING_HPP
+
+# include "Utils.hpp"
+
+// io_uringによるクライアントI/Oエンジン（make IO_URING=1 でビルド時に有効化）
+// - 受信: provided buffer ring を使ったマルチショットrecv
+// - 送信: ループ1周分の送信をfdごとにまとめ、待機と同じio_uring_enterで投入
+// - リスニングソケット/DCCはReactorのepoll fdをマルチショットpollで監視
+// 無効なビルドやカーネルが未対応の場合は init() が false を返し、Reactorを使用する
+
+struct io_uring_sqe;
+
+// wait()が返す完了イベントの種別
+enum UringEventType {
+    URING_RECV,         // データ受信（len == 0 はEOF）
+    URING_CLOSED,       // 受信/送信エラーによる切断
+    URING_REACTOR       // Reactorのepoll fdが読み込み可能
+};
+
+struct UringEvent {
+    UringEventType  type;
+    int             fd;
+    const char*     data;       // URING_RECV: 受信データ（recycle()まで有効）
+    size_t          len;
+    int             bufferId;   // provided buffer のID（-1はなし）
+    int             error;      // URING_CLOSED: errno
+};
+
+class IoUring {
+private:
+    // fdごとの接続状態
+    struct Connection {
+        bool            attached;   // エンジン管理下か
+        unsigned        generation; // fd再利用時の古い完了を判別
+        bool            sending;    // 送信SQEが実行中
+        std::string     pending;    // 未投入の送信データ
+        std::string     inflight;   // 実行中の送信データ（完了まで保持）
+        unsigned        pendingLines;   // pendingに含まれる行数
+        unsigned        inflightLines;  // inflightに含まれる行数
+        bool            recvArmed;  // マルチショットrecvが登録済みか
+        bool            recvPaused; // 受信を停止中（メモリ逼迫時）
+    };
+
+    // 切断後も送信を続ける接続（実行中の送信の完了を待ち、未投入の分を送ってから閉じる）
+    struct OrphanSend {
+        int             fd;         // dup()したfd（元のfdはClientが閉じるため）
+        std::string     inflight;   // 実行中の送信データ（完了まで保持）
+        std::string     pending;    // 実行中の送信の完了後に送るデータ
+    };
+
+    int                         _ringFd;
+    unsigned                    _sqEntries;
+    void*                       _sqRing;
+    void*                       _cqRing;
+    size_t                      _sqRingSize;
+    size_t                      _cqRingSize;
+    struct io_uring_sqe*        _sqes;
+    size_t                      _sqesSize;
+    unsigned*                   _sqHead;
+    unsigned*                   _sqTail;
+    unsigned*                   _sqMask;
+    unsigned*                   _sqArray;
+    unsigned*                   _cqHead;
+    unsigned*                   _cqTail;
+    unsigned*                   _cqMask;
+    void*                       _cqes;
+    unsigned                    _sqLocalTail;   // 未公開のSQ末尾
+
+    // provided buffer ring
+    void*                       _bufRing;
+    size_t                      _bufRingSize;
+    char*                       _bufPool;
+    unsigned short              _bufTail;
+
+    int                         _reactorFd;     // 監視するepoll fd
+    bool                        _reactorQueued; // 今回のwait()でURING_REACTORを追加済みか
+    std::vector<Connection>     _conns;         // fd -> 接続状態
+    std::vector<int>            _sendReady;     // 送信待ちのfd
+    std::map<unsigned long long, OrphanSend> _orphanSends; // 切断後も送信中の接続（送信のuser_dataで検索）
+    std::vector<UringEvent>     _events;
+    size_t                      _queuedBytes;   // 全接続の未送信バイト数（pending + inflight）
+
+    static const unsigned       RING_ENTRIES = 256;
+    static const unsigned       BUFFER_COUNT = 256;     // 2のべき乗
+    static const unsigned       BUFFER_BYTES = 4096;
+    static const unsigned short BUFFER_GROUP = 0;
+    static const unsigned       ORPHAN_TIMEOUT_SECONDS = 10;    // 切断後の送信を待つ上限
+
+    IoUring(const IoUring&);
+    IoUring& operator=(const IoUring&);
+
+    struct io_uring_sqe* getSqe();
+    int                 enter(unsigned minComplete, int timeoutMs);
+    bool                setupRings();
+    bool                setupBufferRing();
+    void                addBuffer(int bufferId);
+    void                armRecv(int fd);
+    void                armReactorPoll();
+    void                submitSend(int fd);
+    void                submitOrphanSend(unsigned long long key, OrphanSend& orphan);
+    void                closeOrphan(std::map<unsigned long long, OrphanSend>::iterator orphan);
+    void                handleCompletion(unsigned long long userData, int res, unsigned flags);
+    Connection&         connection(int fd);
+
+public:
+    IoUring();
+    ~IoUring();
+
+    static bool         isAvailable();
+    bool                init(int reactorFd);
+
+    // クライアントfdの管理
+    void                attach(int fd);
+    void                detach(int fd);
+
+    // 送信（次のwait()でまとめて投入）
+    void                queueSend(int fd, const char* data, size_t length);
+    size_t              getQueuedBytes(int fd) const;
+    size_t              getPendingBytes(int fd) const;  // 切断時にすぐ解放される未投入の分（送信中なら完了後に送るため0）
+    void                discardPending(int fd);     // 未投入の送信データを捨てる（実行中の分は残る）
+    size_t              getQueuedBytes() const;
+
+    // 受信の停止/再開（停止中はrecvを取り消し、カーネルのソケットバッファに留める）
+    void                pauseRecv(int fd);
+    void                resumeRecv(int fd);
+
+    // 投入と待機を1回のシステムコールで行う
+    int                 wait(int timeoutMs);
+    const std::vector<UringEvent>& getEvents() const;
+    void                recycle(const UringEvent& event);
+};
+
+#endif
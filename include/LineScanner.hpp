@@ -0,0 +1,22 @@
+#ifndef LINESCANNER_HPP
+# define LINESCANNER_HPP
+
+# include "Utils.hpp"
+
+// 受信データから改行（LF）と除去が必要な文字（ESC/NUL）を1回の走査で探す
+// x86ではSSE2（実行時にAVX2が使えればAVX2）で16/32バイトずつ比較し、それ以外はスカラーで走査する
+// CRは改行直前の1バイトを見れば足りるため走査対象に含めない
+class LineScanner {
+private:
+    LineScanner();
+
+public:
+    // dataの先頭からLFを探し、その位置を返す（見つからなければlength）
+    // LFより前（LFがなければ末尾まで）にESC/NULがあればspecialをtrueにする（falseには戻さない）
+    static size_t       findLineEnd(const char* data, size_t length, bool& special);
+
+    // 使用中の実装名（"avx2" / "sse2" / "scalar"）
+    static const char*  getBackendName();
+};
+
+#endif
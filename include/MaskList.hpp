@@ -0,0 +1,66 @@
+#ifndef MASKLIST_HPP
+# define MASKLIST_HPP
+
+# include "Utils.hpp"
+# include "HashMap.hpp"
+# include "WildcardMask.hpp"
+
+class Client;
+
+// +b/+e/+I の1エントリ（nick!user@host の各部分を事前に解析して保持）
+struct MaskEntry {
+    std::string     mask;       // 正規化済みの nick!user@host
+    std::string     setBy;      // 設定したクライアントのニックネーム
+    time_t          setAt;      // 設定時刻
+    WildcardMask    nick;
+    WildcardMask    user;
+    WildcardMask    host;
+};
+
+// チャンネルのマスクリスト
+// - ニックネーム部分にリテラルの先頭があるマスクは、その先頭で索引する
+// - それ以外でホスト部分にリテラルの末尾があるマスクは、その末尾で索引する
+// - それ以外でユーザー名部分にリテラルの先頭があるマスクは、その先頭で索引する
+// - どれもないマスク（*!*@* など）だけを毎回全件照合する
+// 照合時はクライアントのニックネーム/ユーザー名の先頭とホストの末尾で索引を引き、候補だけを照合する
+class MaskList {
+private:
+    typedef HashMap<std::string, std::vector<size_t> > Buckets;
+
+    std::vector<MaskEntry>  _entries;           // 設定順（367/348/346の応答順）
+    Buckets                 _byNickPrefix;      // casefold済みのニックネーム先頭 -> エントリ番号
+    Buckets                 _byHostSuffix;      // casefold済みのホスト末尾 -> エントリ番号
+    Buckets                 _byUserPrefix;      // casefold済みのユーザー名先頭 -> エントリ番号
+    std::vector<size_t>     _unindexed;         // 索引できないエントリ番号
+    size_t                  _longestNick;       // 索引にあるニックネーム先頭の最大長
+    size_t                  _longestHost;       // 索引にあるホスト末尾の最大長
+    size_t                  _longestUser;       // 索引にあるユーザー名先頭の最大長
+    size_t                  _memory;            // エントリと索引のヒープ使用量（追加/削除のたびに計り直す）
+
+    void            index(size_t position);
+    void            rebuild();
+    void            measure();
+    static size_t   measureBuckets(const Buckets& buckets);
+    bool            matchesEntry(size_t position, const std::string& nick,
+                                 const std::string& user, const std::string& host) const;
+    bool            matchesBucket(const Buckets& buckets, size_t longest, const std::string& text, bool fromEnd,
+                                  const std::string& nick, const std::string& user, const std::string& host) const;
+
+public:
+    MaskList();
+
+    // "nick" -> "nick!*@*"、"host.name" -> "*!*@host.name"、"user@host" -> "*!user@host"
+    static std::string normalize(const std::string& mask);
+
+    bool            add(const std::string& mask, const std::string& setBy);    // 既に同じマスクがあればfalse
+    bool            remove(const std::string& mask);                            // 該当がなければfalse
+    bool            contains(const std::string& mask) const;
+    bool            matches(const Client* client) const;
+
+    const std::vector<MaskEntry>& getEntries() const;
+    size_t          size() const;
+    bool            empty() const;
+    size_t          getMemoryUsage() const;
+};
+
+#endif
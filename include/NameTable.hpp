@@ -0,0 +1,63 @@
+#ifndef NAMETABLE_HPP
+# define NAMETABLE_HPP
+
+# include "Utils.hpp"
+# include "HashMap.hpp"
+
+// インターン済みの名前（ニックネーム/チャンネル名）を指すID（0は無効）
+typedef unsigned int NameId;
+
+# define INVALID_NAME_ID 0
+
+// 大文字小文字を畳み込んだ名前とそのハッシュ
+struct NameKey {
+    size_t      hash;
+    std::string folded;
+};
+
+inline bool operator==(const NameKey& a, const NameKey& b) {
+    return a.hash == b.hash && a.folded == b.folded;
+}
+
+struct NameKeyHash {
+    size_t operator()(const NameKey& key) const {
+        return key.hash;
+    }
+};
+
+// 名前のインターンテーブル
+// RFC1459のcasemapping（A-Z と []\~ を a-z と {}|^ に対応付け）で同一視した名前に
+// 安定したIDを割り当てる。畳み込んだキーとハッシュは登録時に一度だけ計算する
+// IDは参照カウントで管理し、最後の参照が外れたら再利用する
+class NameTable {
+private:
+    struct Entry {
+        NameKey     key;
+        unsigned    refs;       // 0なら未使用
+    };
+
+    std::vector<Entry>                      _entries;   // ID -> エントリ（0番は予約）
+    std::vector<NameId>                     _freeIds;   // 再利用待ちのID
+    HashMap<NameKey, NameId, NameKeyHash>   _index;     // 畳み込んだ名前 -> ID
+
+    static void         makeKey(const std::string& name, NameKey& key);
+
+public:
+    NameTable();
+
+    static char         foldChar(char c);
+    static std::string  casefold(const std::string& name);
+    static bool         equals(const std::string& a, const std::string& b);
+
+    // 登録済みならID、なければINVALID_NAME_ID（登録はしない）
+    NameId              lookup(const std::string& name) const;
+
+    // 登録（既にあれば参照を1つ増やす）と解放
+    NameId              acquire(const std::string& name);
+    void                release(NameId id);
+
+    const std::string&  getFolded(NameId id) const;
+    size_t              size() const;
+};
+
+#endif
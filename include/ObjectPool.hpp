@@ -0,0 +1,111 @@
+#ifndef OBJECTPOOL_HPP
+# define OBJECTPOOL_HPP
+
+# include "Utils.hpp"
+# include <new>
+
+// プールの使用状況（ステータス表示用）
+struct PoolStats {
+    const char*     name;
+    size_t          objectSize;     // 1スロットのバイト数
+    size_t          inUse;          // 使用中のスロット数
+    size_t          highWater;      // 使用中スロット数の最大値
+    size_t          capacity;       // 確保済みのスロット数
+    size_t          slabs;          // 確保済みのスラブ数
+    unsigned long   allocations;    // 累計の割り当て回数
+};
+
+// 同じ型のオブジェクトを固定サイズのスロットに割り当てるスラブアロケータ
+// - スロットはSlotsPerSlab個ずつまとめて確保し、解放されたスロットはフリーリストで再利用する
+// - スラブはプールの破棄まで保持する（接続の増減でヒープが断片化しないように）
+// 使い方: T* obj = new (pool.allocate()) T(...); ... pool.destroy(obj);
+template <class T, size_t SlotsPerSlab = 64>
+class ObjectPool {
+private:
+    union Slot {
+        Slot*       next;                   // 空きスロットの連結
+        long double alignLongDouble;        // アラインメント確保用
+        void*       alignPointer;
+        char        storage[sizeof(T)];
+    };
+
+    std::vector<Slot*>  _slabs;
+    Slot*               _free;
+    PoolStats           _stats;
+
+    void grow() {
+        Slot* slab = static_cast<Slot*>(::operator new(sizeof(Slot) * SlotsPerSlab));
+        for (size_t i = 0; i < SlotsPerSlab; ++i) {
+            slab[i].next = (i + 1 < SlotsPerSlab) ? &slab[i + 1] : _free;
+        }
+        _free = slab;
+        _slabs.push_back(slab);
+        _stats.capacity += SlotsPerSlab;
+        _stats.slabs++;
+    }
+
+    // コピー禁止
+    ObjectPool(const ObjectPool&);
+    ObjectPool& operator=(const ObjectPool&);
+
+public:
+    explicit ObjectPool(const char* name) : _free(NULL) {
+        _stats.name = name;
+        _stats.objectSize = sizeof(Slot);
+        _stats.inUse = 0;
+        _stats.highWater = 0;
+        _stats.capacity = 0;
+        _stats.slabs = 0;
+        _stats.allocations = 0;
+    }
+
+    ~ObjectPool() {
+        if (_stats.inUse > 0) {
+            std::cout << "\033[1;31m[POOL] " << _stats.name << ": " << _stats.inUse
+                      << " objects still in use at shutdown\033[0m" << std::endl;
+        }
+        for (size_t i = 0; i < _slabs.size(); ++i) {
+            ::operator delete(_slabs[i]);
+        }
+    }
+
+    // 未初期化のスロットを返す（placement newで構築する）
+    void* allocate() {
+        if (!_free) {
+            grow();
+        }
+        Slot* slot = _free;
+        _free = slot->next;
+        _stats.inUse++;
+        _stats.allocations++;
+        if (_stats.inUse > _stats.highWater) {
+            _stats.highWater = _stats.inUse;
+        }
+        return slot->storage;
+    }
+
+    void deallocate(void* pointer) {
+        if (!pointer) {
+            return;
+        }
+        Slot* slot = static_cast<Slot*>(pointer);
+        slot->next = _free;
+        _free = slot;
+        _stats.inUse--;
+    }
+
+    // デストラクタを呼んでからスロットを返却
+    void destroy(T* object) {
+        if (!object) {
+            return;
+        }
+        object->~T();
+        deallocate(object);
+    }
+
+    const PoolStats& getStats() const {
+        return _stats;
+    }
+};
+
+#endif
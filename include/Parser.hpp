@@ -3,16 +3,56 @@
 
 # include "Utils.hpp"
 
+# define MAX_MESSAGE_PARAMS 15  // RFC 2812のパラメータ数上限
+# define MAX_COMMAND_LENGTH 16  // コマンド名の最大長
+
+// 行内の位置と長さ（行は最大512バイト）
+struct MessageSlice {
+    unsigned short  offset;
+    unsigned short  length;
+};
+
+// パラメータの参照（行を保持するバッファが有効な間のみ使用可能）
+// 必要になったパラメータだけをstd::stringにする
+class ParamList {
+private:
+    const char*     _line;
+    MessageSlice    _slices[MAX_MESSAGE_PARAMS];
+    size_t          _count;
+
+public:
+    ParamList();
+    ParamList(const char* line, const MessageSlice* slices, size_t count);
+
+    size_t          size() const;
+    bool            empty() const;
+    std::string     operator[](size_t index) const;
+
+    // コピーせずに参照する場合
+    const char*     data(size_t index) const;
+    size_t          length(size_t index) const;
+    bool            equals(size_t index, const char* value) const;
+
+    // 先頭count個を除いた参照（サブコマンドの処理用）
+    ParamList       shift(size_t count) const;
+};
+
+// ヒープを使わないメッセージパーサー（結果は元の行への位置と長さで保持）
 class Parser {
 private:
-    std::string _message;
-    std::string _prefix;
-    std::string _command;
-    std::vector<std::string> _params;
-    bool _valid;
+    const char*     _message;
+    size_t          _length;
+    MessageSlice    _prefix;
+    char            _command[MAX_COMMAND_LENGTH + 1];   // 大文字化したコマンド名
+    MessageSlice    _params[MAX_MESSAGE_PARAMS];
+    size_t          _paramCount;
+    bool            _valid;
+
+    size_t          skipSpaces(size_t pos) const;
+    size_t          findSpace(size_t pos) const;
 
 public:
-    Parser(const std::string& message);
+    Parser(const char* message, size_t length);
     ~Parser();
 
     // パース処理
@@ -21,7 +61,8 @@ public:
     // ゲッター
     std::string getPrefix() const;
     std::string getCommand() const;
-    std::vector<std::string> getParams() const;
+    const char* getCommandName() const;
+    ParamList getParams() const;
     bool isValid() const;
 
     // デバッグ用
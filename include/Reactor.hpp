@@ -0,0 +1,94 @@
+#ifndef REACTOR_HPP
+# define REACTOR_HPP
+
+# include "Utils.hpp"
+# ifdef __linux__
+#  include <sys/epoll.h>
+# endif
+
+class Client;
+class DCCTransfer;
+
+// 監視対象fdの種別
+enum FdKind {
+    FD_NONE,        // 未登録
+    FD_LISTENER,    // サーバーのリスニングソケット
+    FD_CLIENT,      // IRCクライアントソケット
+    FD_DCC_LISTEN,  // DCC送信側のリスニングソケット
+    FD_DCC_DATA,    // DCCデータ転送ソケット
+    FD_CONSOLE      // 標準入力（ステータス表示の操作）
+};
+
+// fdごとのハンドラ情報（fdをインデックスとするテーブルに格納）
+struct FdHandler {
+    FdKind          kind;       // fdの種別
+    short           events;     // 監視中のイベント（POLLIN / POLLOUT）
+    Client*         client;     // FD_CLIENTの場合の所有クライアント
+    DCCTransfer*    transfer;   // FD_DCC_*の場合の転送
+};
+
+// wait()が返す準備完了イベント
+struct ReadyEvent {
+    int             fd;
+    bool            readable;   // 読み込み可能
+    bool            writable;   // 書き込み可能
+    bool            error;      // HUP / ERR
+};
+
+// I/O系システムコールとメッセージ数の統計（syscalls/msgの算出に使用）
+struct IoStats {
+    unsigned long   waitCalls;      // epoll_wait / poll / io_uring_enter
+    unsigned long   recvCalls;      // recv
+    unsigned long   sendCalls;      // send
+    unsigned long   messagesIn;     // 処理した受信メッセージ数
+    unsigned long   messagesOut;    // 送信したメッセージ数
+    unsigned long   writeBatches;   // 送信キューの書き出し回数（writev / io_uring SEND）
+    unsigned long   linesWritten;   // 書き出しで送り切った行数
+
+    static IoStats& instance();
+    unsigned long   totalSyscalls() const;
+    double          syscallsPerMessage() const;
+    double          linesPerWrite() const;
+};
+
+// イベント多重化（Linuxではepoll、それ以外ではpollを使用）
+// fdは追加・削除時にのみ登録を変更し、ループ毎の再構築は行わない
+class Reactor {
+private:
+    std::vector<FdHandler>          _handlers;      // fd -> ハンドラ
+    std::vector<ReadyEvent>         _ready;         // 直近のwait()結果
+    size_t                          _watchedCount;  // 登録中のfd数
+# ifdef __linux__
+    int                             _epollFd;       // epollインスタンス
+    std::vector<struct epoll_event> _epollEvents;   // epoll_wait用バッファ
+# else
+    std::vector<struct pollfd>      _pollfds;       // poll用のfd配列（登録時のみ更新）
+    std::vector<int>                _pollIndex;     // fd -> _pollfds内のインデックス
+# endif
+
+    Reactor(const Reactor&);
+    Reactor& operator=(const Reactor&);
+
+public:
+    Reactor();
+    ~Reactor();
+
+    bool                init();
+
+    // fdの登録管理
+    bool                add(int fd, FdKind kind, short events, Client* client = NULL, DCCTransfer* transfer = NULL);
+    bool                modify(int fd, short events);
+    void                remove(int fd);
+    const FdHandler*    getHandler(int fd) const;
+
+    // イベント待機（準備完了イベント数、エラー時は-1を返す）
+    int                 wait(int timeoutMs);
+    const std::vector<ReadyEvent>& getReadyEvents() const;
+
+    // 状態
+    int                 getFd() const;
+    size_t              getWatchedCount() const;
+    const char*         getBackendName() const;
+};
+
+#endif
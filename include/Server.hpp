@@ -5,31 +5,180 @@
 # include "Client.hpp"
 # include "Channel.hpp"
 # include "Parser.hpp"
+# include "Reactor.hpp"
+# include "IoUring.hpp"
+# include "TimerWheel.hpp"
+# include "NameTable.hpp"
+# include "HashMap.hpp"
+# include "WhoQuery.hpp"
+# include "ObjectPool.hpp"
+# include "Arena.hpp"
 # include <cstdio>
 
 class Command;
 class CommandFactory;
 class BotManager;
 class DCCManager;
+class DCCTransfer;
 
 class NickCommand;
 
-class Server {
+// 接続受け入れの統計
+struct AcceptStats {
+    unsigned long   accepted;           // 受け入れた接続の総数
+    unsigned long   capHits;            // 上限に達してaccept待ちを次回に持ち越した回数
+    unsigned long   windowCount;        // 現在の計測区間で受け入れた数
+    time_t          windowStart;        // 計測区間の開始時刻
+    double          perSecond;          // 直近の受け入れレート（接続/秒）
+    long            overflowBase;       // 起動時のListenOverflows（-1は取得不可）
+};
+
+// キープアライブの統計
+struct KeepaliveStats {
+    unsigned long               pingsSent;      // 送信したPING数
+    unsigned long               pongsMatched;   // トークンが一致したPONG数
+    unsigned long               timeouts;       // PONGが返らず切断した数
+    std::vector<long>           rttSamples;     // 直近のRTT（リングバッファ、ミリ秒）
+    size_t                      rttNext;        // 次に書き込む位置
+};
+
+// ステータス表示用の集計（状態変更時に増分更新し、表示時に全体を走査しない）
+struct StatusSnapshot {
+    size_t          clients;            // 接続中のクライアント数
+    size_t          channels;           // チャンネル数
+    size_t          nicknames;          // ニックネームマップの登録数
+    unsigned long   connects;           // 累計接続数
+    unsigned long   disconnects;        // 累計切断数
+    unsigned long   nickChanges;        // ニックネーム登録/変更の回数
+    unsigned long   version;            // 状態変更のたびに増加
+    unsigned long   renderedVersion;    // 最後に表示したversion
+    unsigned long   renders;            // 表示回数
+};
+
+// コマンドスケジューラの統計（1イテレーションで実行した行数と、実行待ちの時間）
+struct SchedulerStats {
+    unsigned long       iterations;         // スケジューラを回した回数
+    size_t              lastWork;           // 直近のイテレーションで実行したコマンドの重みの合計
+    size_t              maxWork;            // 1イテレーションで実行した重みの最大値
+    unsigned long long  totalWork;          // 累計の実行した重み
+    unsigned long       budgetHits;         // 上限に達して実行待ちを次に持ち越した回数
+    size_t              maxQueued;          // 実行待ちのクライアント数の最大値
+    unsigned long long  maxWaitMs;          // 実行待ちに入ってから順番が来るまでの最大時間
+    unsigned long long  recentMaxWaitMs;    // 前回のステータス表示以降の最大待ち時間
+};
+
+// フラッド制御の統計
+struct FloodStats {
+    unsigned long   holds;              // トークン不足で入力を保留した回数
+    unsigned long   deferredLines;      // 保留で後回しにした行数（再開時に処理される）
+    size_t          heldClients;        // 現在保留中のクライアント数
+};
+
+// 送信キュー（SendQ）の接続クラス
+enum SendQClassId {
+    SENDQ_UNREGISTERED,     // 登録前
+    SENDQ_USER,             // 登録済みユーザー
+    SENDQ_OPERATOR,         // オペレーター
+    SENDQ_CLASS_COUNT
+};
+
+// 接続クラスごとの送信キュー上限と、低速な接続として切断した数
+struct SendQClass {
+    const char*     name;
+    size_t          limit;              // これを超えたら即座に切断（バイト）
+    size_t          watermark;          // これを超えたままstallSeconds続いたら切断（バイト）
+    unsigned long   exceeded;           // 上限超過で切断した数
+    unsigned long   stalled;            // ウォーターマーク超過が続いて切断した数
+};
+
+// サブシステムごとのメモリ使用量（プールの使用中スロットと未送信データから算出）
+struct MemoryUsage {
+    size_t          clients;            // Client（受信バッファを含むスロットと、名前・参加チャンネル一覧・送信キュー・取っておいた受信データ）
+    size_t          channels;           // Channel（スロットと、参加者一覧・索引・招待リスト・マスクリスト）
+    size_t          messages;           // 送信キューが参照する行バッファ
+    size_t          transfers;          // DCC転送（ファイルバッファを含む）
+    size_t          ioUring;            // io_uringの未送信データ
+    size_t          arena;              // イテレーションごとの一時領域
+
+    size_t          total() const { return clients + channels + messages + transfers + ioUring + arena; }
+};
+
+// メモリ予算とバックプレッシャーの統計
+struct MemoryStats {
+    size_t          budget;             // 予算（バイト）
+    size_t          peak;               // 使用量の最大値
+    bool            underPressure;      // 受信停止中（予算のMEMORY_PAUSE_PERCENTを超えてから、MEMORY_RESUME_PERCENTを下回るまで）
+    time_t          lastRebalance;      // 受信停止の対象を最後に選び直した時刻
+    size_t          pausedClients;      // 受信停止中のクライアント数
+    unsigned long   pauses;             // 受信を停止した累計回数
+    unsigned long   sheds;              // 予算超過で切断した累計数
+};
+
+// 直近の接続ログ（ステータス表示用）
+struct ConnectionLogEntry {
+    time_t          time;
+    std::string     text;
+    std::string     color;
+};
+
+// 名前（インターン済みID）をキーにしたハッシュテーブル
+typedef HashMap<NameId, Channel*>   ChannelMap;
+typedef HashMap<NameId, Client*>    NicknameMap;
+
+// casefold済みニックネームの順序付き索引（WHOの前方一致での絞り込み用）
+typedef std::map<std::string, Client*> NickOrder;
+
+class Server : public TimerHandler {
 private:
     int                                 _serverSocket;       // サーバーのリスニングソケット
     std::string                         _password;           // 接続パスワード
     std::string                         _hostname;           // サーバーホスト名
     int                                 _port;               // リスニングポート
+    ObjectPool<Client, 16>              _clientPool;         // Clientのスラブ（受信バッファを含むため1スロットが大きい）
+    ObjectPool<Channel, 64>             _channelPool;        // Channelのスラブ
     std::map<int, Client*>              _clients;            // クライアントマップ (fd -> Client*)
-    std::map<std::string, Channel*>     _channels;           // チャンネルマップ (name -> Channel*)
-    std::map<std::string, Client*>      _nicknames;          // ニックネームマップ (nickname -> Client*)
-    std::vector<pollfd>                 _pollfds;            // poll用のfd配列
+    NameTable                           _names;              // ニックネーム/チャンネル名のインターンテーブル
+    ChannelMap                          _channels;           // チャンネルマップ (name id -> Channel*)
+    NicknameMap                         _nicknames;          // ニックネームマップ (nickname id -> Client*)
+    NickOrder                           _nickOrder;          // ニックネーム順の索引 (casefold済み -> Client*)
+    std::deque<WhoQuery>                _whoQueue;           // 続きを送る必要のあるWHO（先着順）
+    Reactor                             _reactor;            // イベント多重化（fd -> ハンドラ）
+    IoUring*                            _ioUring;            // io_uringエンジン（無効時はNULL）
+    TimerWheel                          _timers;             // タイムアウト管理（クライアント/DCC/Bot）
+    Timer                               _statusTimer;        // 保留中のステータス再表示
+    StatusSnapshot                      _statusSnapshot;     // ステータス表示用の集計
+    std::deque<ConnectionLogEntry>      _connectionLog;      // 直近の接続ログ
+    int                                 _statusInterval;     // ステータス再表示の最短間隔（ミリ秒）
+    unsigned long long                  _lastStatusRender;   // 最後に表示した時刻（ミリ秒）
+    bool                                _headless;           // ステータス表示を行わない（本番運用向け）
+    bool                                _consoleWatched;     // 標準入力を監視中か
+    bool                                _debugChecks;        // 名前の索引を変更のたびに検証する（デバッグ用）
     bool                                _running;            // サーバー実行中フラグ
     CommandFactory*                     _commandFactory;     // コマンドファクトリー
     BotManager*                         _botManager;         // Bot管理
     DCCManager*                         _dccManager;         // DCC転送管理
     time_t                              _startTime;          // サーバー起動時間
     bool                                _detailedView;       // 詳細表示モード
+    Arena                               _arena;              // イテレーション内だけ使う一時領域（実行中の行など、ループ先頭で破棄）
+    std::vector<int>                    _flushList;          // このイテレーションで送信キューに追加があったfd
+    std::vector<int>                    _disconnectList;     // 切断予定になったfd（ループ末尾でまとめて削除）
+    int                                 _listenBacklog;      // listen()のバックログ
+    AcceptStats                         _acceptStats;        // 接続受け入れの統計
+    int                                 _pingInterval;       // 無通信でPINGを送るまでの秒数
+    int                                 _pingTimeout;        // PONGを待つ秒数
+    KeepaliveStats                      _keepaliveStats;     // キープアライブの統計
+    std::deque<int>                     _runQueue;           // 受信済みの行を実行待ちのfd（先着順に1回K行まで）
+    int                                 _linesPerTurn;       // 1クライアントが1回の順番で実行する最大行数
+    int                                 _workPerIteration;   // 1イテレーションで実行するコマンドの重みの合計の上限
+    SchedulerStats                      _schedulerStats;     // コマンドスケジューラの統計
+    int                                 _floodBurst;         // トークンバケットの容量（コマンドの重みの合計）
+    int                                 _floodRate;          // 1秒あたりに補充する重み
+    FloodStats                          _floodStats;         // フラッド制御の統計
+    std::vector<int>                    _floodReady;         // トークンが貯まり、保留中の行を処理できるfd
+    SendQClass                          _sendQClasses[SENDQ_CLASS_COUNT]; // 接続クラスごとの送信キュー上限
+    int                                 _sendQStallSeconds;  // ウォーターマーク超過を許す秒数
+    MemoryStats                         _memoryStats;        // メモリ予算とバックプレッシャーの統計
+    std::vector<int>                    _pausedFds;          // 受信停止中のfd
 
 public:
     friend class NickCommand;
@@ -48,24 +197,64 @@ public:
     void            removeClient(int fd);
     void            removeClient(const std::string& nickname);
     bool            isNicknameInUse(const std::string& nickname);
-    void            updateNickname(const std::string& oldNick, const std::string& newNick);
+    void            updateNickname(Client* client, const std::string& newNick);
+    int             verifyNicknameIndex(std::ostream& out);
+    const NickOrder& getNickOrder() const;
+
+    // WHO（大量の応答はイテレーションをまたいで送る）
+    void            startWhoQuery(const WhoQuery& query);
 
     // チャンネル管理
     Channel*        getChannel(const std::string& name);
+    Channel*        getChannel(NameId id);
     void            createChannel(const std::string& name, Client* creator);
-    void            removeChannel(const std::string& name);
+    void            destroyChannel(Channel* channel);
     bool            channelExists(const std::string& name) const;
-    std::map<std::string, Channel*>& getChannels();
+    ChannelMap&     getChannels();
 
     // メッセージ処理
     void            processClientMessage(int fd);
-    void            executeCommand(Client* client, const std::string& message);
+    void            handleClientInput(Client* client, const char* data, size_t length);
+    void            updateWriteInterest(Client* client);
+    void            updateReadInterest(Client* client);
+    void            requestFlush(Client* client);
+    void            requestDisconnect(Client* client);
+    void            executeCommand(Client* client, const char* message, size_t length);
     
     // Bot管理
     BotManager*     getBotManager();
     
     // DCC管理
     DCCManager*     getDCCManager();
+    void            watchDCCSocket(int fd, DCCTransfer* transfer);
+    void            unwatchFd(int fd);
+
+    // I/Oエンジン
+    IoUring*        getIoUring();
+
+    // タイマー
+    TimerWheel&     getTimers();
+    void            onTimer(Timer& timer);
+
+    // キープアライブ
+    int             getPingInterval() const;
+    int             getPingTimeout() const;
+    void            recordPingSent();
+    void            recordPingRtt(long rttMs);
+    void            recordPingTimeout();
+    long            getRttPercentile(double percentile) const;
+
+    // フラッド制御（トークンバケット、足りない間は行を受信バッファに残す）
+    int             getFloodBurst() const;
+    int             getFloodRate() const;
+    void            scheduleHeldInput(Client* client);
+
+    // 送信キューの上限（低速な接続の検出と切断）
+    SendQClassId    getSendQClass(const Client* client) const;
+    void            checkSendQ(Client* client);
+
+    // メモリ予算
+    MemoryUsage     getMemoryUsage() const;
 
     // 接続管理
     bool            authenticateClient(Client* client, const std::string& password);
@@ -77,24 +266,46 @@ public:
     int             getPort() const;
     time_t          getStartTime() const;
 
-    // サーバー状態表示
+    // サーバー状態表示（状態変更はmarkStatusDirtyで通知し、表示は間隔ごとに1回まで）
+    void            markStatusDirty();
+    void            renderStatus();
     void            displayServerStatus();
-    void            showRecentConnections();
+    void            showRecentConnections(std::ostream& out);
     void            addConnectionLog(const std::string& log, const std::string& color);
     void            toggleDetailedView();
-    void            displayDetailedStatus();
+    void            displayDetailedStatus(std::ostream& out);
+    static void     writePoolStats(std::ostream& out, const PoolStats& stats);
     void            checkInput();
+    const StatusSnapshot& getStatusSnapshot() const;
 
 private:
     // ソケット初期化
     void            initializeSocket();
     void            setNonBlocking(int fd);
     void            handleNewConnection();
-    void            handleClientData(size_t i);
+    bool            acceptConnection();
+    void            updateAcceptRate(time_t now);
+    long            readListenOverflows() const;
+    int             waitForEvents(int timeoutMs);
+    void            dispatchReadyEvents();
+    void            dispatchIoUringEvents();
+    void            handleClientData(int fd);
+    void            scheduleClient(Client* client);
+    void            runScheduledClients();
+    bool            processClientLines(Client* client, size_t lineLimit, size_t workLimit, size_t& processed, size_t& work);
+    void            handleClientWrite(int fd);
+    void            flushPendingOutput();
+    void            handleDCCEvent(const ReadyEvent& event);
     void            checkDisconnectedClients();
-	void            checkAndRemoveEmptyChannels();
-    void            updatePollFds();
-    void            removePollFd(int fd);
+    void            continueWhoQueries();
+    void            checkMemoryPressure();
+    void            pauseHeaviestSenders();
+    void            resumePausedClients();
+    void            shedLargestQueues(size_t usage);
+    void            setReadPaused(Client* client, bool paused);
+    void            holdClientInput(Client* client, unsigned cost);
+    void            resumeHeldInput();
+    bool            hasRunnableWhoQuery() const;
 };
 
 #endif
\ No newline at end of file
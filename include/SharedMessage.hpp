@@ -0,0 +1,38 @@
+#ifndef SHAREDMESSAGE_HPP
+# define SHAREDMESSAGE_HPP
+
+# include "Utils.hpp"
+# include "ObjectPool.hpp"
+
+// 送信用に整形済みの1行（CRLF付き、作成後は変更しない）
+// ブロードキャストでは1回だけ作成し、各受信者の送信キューには参照を積む
+// 行の本体は固定長スロットのプールから取る（メッセージごとのヒープ割り当てなし）
+class SharedMessage {
+private:
+    struct Buffer {
+        size_t          refs;
+        size_t          length;
+        char            data[MAX_MESSAGE_LENGTH + 2];   // CRLFのない512バイトの行にCRLFを付けた分まで
+    };
+
+    static ObjectPool<Buffer, 256> _pool;
+
+    Buffer*             _buffer;
+
+    void                release();
+
+public:
+    SharedMessage();
+    explicit SharedMessage(const std::string& message);
+    SharedMessage(const SharedMessage& other);
+    SharedMessage& operator=(const SharedMessage& other);
+    ~SharedMessage();
+
+    const char*         data() const;
+    size_t              length() const;
+    bool                isShared() const;       // 他にも参照している送信キューがあるか
+
+    static const PoolStats& getPoolStats();
+};
+
+#endif
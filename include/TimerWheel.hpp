@@ -0,0 +1,83 @@
+#ifndef TIMERWHEEL_HPP
+# define TIMERWHEEL_HPP
+
+# include "Utils.hpp"
+
+class Timer;
+class TimerWheel;
+
+// タイマー満了時のコールバック
+class TimerHandler {
+public:
+    virtual ~TimerHandler() {}
+    virtual void    onTimer(Timer& timer) = 0;
+};
+
+// ホイールに登録するタイマー（所有者のメンバーとして保持し、破棄時に自動で解除）
+class Timer {
+private:
+    friend class TimerWheel;
+
+    Timer*              _prev;      // スロット内の双方向リスト
+    Timer*              _next;
+    TimerWheel*         _wheel;     // 登録中のホイール（未登録はNULL）
+    unsigned long       _expires;   // 満了tick
+    int                 _level;     // 登録中の階層
+    int                 _slot;      // 登録中のスロット
+    TimerHandler*       _handler;
+    void*               _context;   // ハンドラ側で対象を識別するための値
+
+    Timer(const Timer&);
+    Timer& operator=(const Timer&);
+
+public:
+    Timer();
+    ~Timer();
+
+    void                setHandler(TimerHandler* handler, void* context = NULL);
+    void*               getContext() const;
+    bool                isScheduled() const;
+    void                cancel();
+};
+
+// 階層型タイミングホイール（登録・解除ともにO(1)）
+// 1tick = TICK_MS ミリ秒、64スロット x 4階層で約46時間先まで表現できる
+class TimerWheel {
+private:
+    static const int            LEVELS = 4;
+    static const int            SLOT_BITS = 6;
+    static const int            SLOTS = 1 << SLOT_BITS;
+    static const unsigned long  TICK_MS = 10;
+
+    Timer*              _slots[LEVELS][SLOTS];
+    unsigned long long  _baseMs;        // tick 0 の時刻
+    unsigned long       _currentTick;   // 処理済みのtick
+    size_t              _count;         // 登録中のタイマー数
+
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+
+    void                link(Timer& timer);
+    void                unlink(Timer& timer);
+    void                cascade(int level);
+    unsigned long       tickAt(unsigned long long ms) const;
+
+public:
+    TimerWheel();
+    ~TimerWheel();
+
+    static unsigned long long nowMs();
+
+    // delayMs後に満了するよう登録（登録済みの場合は再登録）
+    void                schedule(Timer& timer, unsigned long delayMs);
+    void                cancel(Timer& timer);
+
+    // 現在時刻までに満了したタイマーのハンドラを呼び出す
+    void                advance(unsigned long long nowMs);
+
+    // 次の満了までのミリ秒（タイマーがなければ-1）
+    int                 nextTimeoutMs(unsigned long long nowMs) const;
+    size_t              size() const;
+};
+
+#endif
@@ -9,12 +9,15 @@
 # include <cstdlib>
 # include <cerrno>
 # include <vector>
+# include <deque>
 # include <map>
 # include <algorithm>
 # include <sstream>
 # include <sys/types.h>
 # include <sys/socket.h>
+# include <sys/uio.h>
 # include <netinet/in.h>
+# include <netinet/tcp.h>
 # include <arpa/inet.h>
 # include <netdb.h>
 # include <unistd.h>
@@ -31,7 +34,36 @@
 # define IRC_CREATION_DATE "2025-03-28"
 # define MAX_CLIENTS 100
 # define BUFFER_SIZE 1024
+# define RECV_BUFFER_SIZE 8192  // クライアントごとの受信バッファ（recvが直接書き込む）
+# define MAX_INPUT_LINE 4096  // 1行の最大長（超えた行はERR_INPUTTOOLONGで破棄）
+# define MAX_MESSAGE_LENGTH 512  // 送信する1行の最大長（CRLFを含む）
+# define MAX_WRITE_IOV 64  // 1回のwritevでまとめる最大行数
+# define DEFAULT_LISTEN_BACKLOG 128  // listen()のバックログ（IRC_LISTEN_BACKLOGで変更可）
+# define MAX_ACCEPTS_PER_ITERATION 64  // 1イテレーションで受け入れる最大接続数
+# define REGISTRATION_TIMEOUT 60  // 登録完了までの猶予（秒）
+# define DEFAULT_PING_INTERVAL 120  // 無通信でPINGを送るまでの時間（秒、IRC_PING_INTERVALで変更可）
+# define DEFAULT_PING_TIMEOUT 60  // PONGを待つ時間（秒、IRC_PING_TIMEOUTで変更可）
+# define RTT_SAMPLE_COUNT 1024  // RTTパーセンタイル算出に使う直近のサンプル数
+# define DEFAULT_STATUS_INTERVAL 1000  // ステータス再表示の最短間隔（ミリ秒、IRC_STATUS_INTERVALで変更可）
+# define CONNECTION_LOG_SIZE 10  // ステータスに表示する直近の接続ログ数
+# define WHO_ENTRIES_PER_TURN 512  // 1イテレーションでWHOが調べる最大ユーザー数（残りは次のイテレーションへ）
+# define WHO_MAX_QUEUED_OUTPUT 65536  // 要求元の送信キューがこれを超えている間はWHOの続きを保留
+# define ARENA_CHUNK_SIZE 65536  // イテレーションごとの一時領域の最小チャンクサイズ
+# define DEFAULT_LINES_PER_TURN 8  // 1クライアントが1回の順番で実行する最大行数（IRC_LINES_PER_TURNで変更可）
+# define DEFAULT_WORK_PER_ITERATION 512  // 1イテレーションで実行するコマンドの重みの合計の上限（IRC_WORK_PER_ITERATIONで変更可）
+# define DEFAULT_FLOOD_BURST 20  // 連続して処理できるコマンドの重みの合計（IRC_FLOOD_BURSTで変更可）
+# define DEFAULT_FLOOD_RATE 10  // 1秒あたりに補充する重み（IRC_FLOOD_RATEで変更可）
+# define DEFAULT_SENDQ_UNREGISTERED_KB 64  // 登録前の接続の送信キュー上限（KB、IRC_SENDQ_UNREGISTERED_KBで変更可）
+# define DEFAULT_SENDQ_USER_KB 512  // 登録済みユーザーの送信キュー上限（KB、IRC_SENDQ_USER_KBで変更可）
+# define DEFAULT_SENDQ_OPERATOR_KB 2048  // オペレーターの送信キュー上限（KB、IRC_SENDQ_OPERATOR_KBで変更可）
+# define SENDQ_WATERMARK_PERCENT 50  // 上限のこの割合を超えたまま続いたら低速な接続とみなす
+# define DEFAULT_SENDQ_STALL_SECONDS 30  // ウォーターマーク超過を許す時間（秒、IRC_SENDQ_STALL_SECONDSで変更可）
+# define DEFAULT_MEMORY_BUDGET_KB 262144  // サーバー全体のメモリ予算（KB、IRC_MEMORY_BUDGET_KBで変更可）
+# define MEMORY_PAUSE_PERCENT 80  // 予算のこの割合を超えたら送信量の多いクライアントの受信を停止
+# define MEMORY_RESUME_PERCENT 60  // この割合を下回ったら受信を再開
+# define MEMORY_PAUSE_SHARE 10  // 受信を停止するクライアントの割合（%、最低1人）
 # define MAX_CHANNELS 100
+# define MAX_CHANNEL_MASKS 100  // +b/+e/+I それぞれの最大エントリ数（超えたらERR_BANLISTFULL）
 # define CHANNEL_PREFIX '#'
 
 // レスポンスコード
@@ -45,6 +77,7 @@
 # define ERR_NOORIGIN 409
 # define ERR_NORECIPIENT 411
 # define ERR_NOTEXTTOSEND 412
+# define ERR_INPUTTOOLONG 417
 # define ERR_NONICKNAMEGIVEN 431
 # define ERR_ERRONEUSNICKNAME 432
 # define ERR_NICKNAMEINUSE 433
@@ -63,6 +96,7 @@
 # define ERR_BANNEDFROMCHAN 474
 # define ERR_BADCHANNELKEY 475
 # define ERR_BADCHANMASK 476
+# define ERR_BANLISTFULL 478
 # define ERR_CHANOPRIVSNEEDED 482
 # define ERR_UMODEUNKNOWNFLAG 501
 # define ERR_USERSDONTMATCH 502
@@ -75,13 +109,21 @@
 # define RPL_UMODEIS 221
 # define RPL_AWAY 301
 # define RPL_UNAWAY 305
+# define RPL_ENDOFWHO 315
 # define RPL_NOWAWAY 306
 # define RPL_CHANNELMODEIS 324
 # define RPL_NOTOPIC 331
 # define RPL_TOPIC 332
 # define RPL_INVITING 341
+# define RPL_INVITELIST 346
+# define RPL_ENDOFINVITELIST 347
+# define RPL_EXCEPTLIST 348
+# define RPL_ENDOFEXCEPTLIST 349
+# define RPL_WHOREPLY 352
 # define RPL_NAMREPLY 353
 # define RPL_ENDOFNAMES 366
+# define RPL_BANLIST 367
+# define RPL_ENDOFBANLIST 368
 # define RPL_MOTDSTART 375
 # define RPL_MOTD 372
 # define RPL_ENDOFMOTD 376
@@ -133,6 +175,9 @@ namespace Utils {
 
     // レスポンス整形
     std::string formatResponse(int code, const std::string& target, const std::string& message);
+
+    // 環境変数から整数設定を読み込む
+    int getEnvInt(const char* name, int defaultValue, int minValue, int maxValue);
 }
 
 #endif
\ No newline at end of file
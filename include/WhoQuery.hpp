@@ -0,0 +1,43 @@
+#ifndef WHOQUERY_HPP
+# define WHOQUERY_HPP
+
+# include "Utils.hpp"
+# include "WildcardMask.hpp"
+
+class Server;
+class Client;
+
+// チャンネル以外を対象にしたWHOの検索条件と進行状況
+// - ワイルドカードなしのニックネームはニックネーム索引で直接引く
+// - マスクは事前に解析し、リテラルの先頭部分でニックネーム順の索引を絞り込んで走査する
+// - 1回の実行で調べる件数を制限し、残りは次のイテレーションで続ける
+class WhoQuery {
+private:
+    int             _fd;            // 要求元のfd（切断時にキューから外すため）
+    Client*         _requester;
+    std::string     _mask;          // 315で返す元のマスク
+    bool            _operOnly;      // "WHO <mask> o"（サーバーオペレータのみ）
+    bool            _fullForm;      // nick!user@host 形式のマスク
+    WildcardMask    _nick;
+    WildcardMask    _user;
+    WildcardMask    _host;
+    std::string     _cursor;        // 最後に調べたニックネーム（casefold済み）
+    bool            _started;
+
+public:
+    WhoQuery(Client* requester, const std::string& mask, bool operOnly);
+
+    int             getFd() const;
+    Client*         getRequester() const;
+
+    bool            matches(const Client* target) const;
+
+    // 調べた件数だけbudgetを減らしながら応答する。315まで送り終えたらtrue
+    bool            run(Server* server, size_t& budget);
+
+    // 352を1行送る（チャンネル指定のWHOと共通）
+    static void     sendReply(Server* server, Client* requester, const Client* target,
+                              const std::string& channelName, const std::string& memberPrefix);
+};
+
+#endif
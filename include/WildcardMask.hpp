@@ -0,0 +1,31 @@
+#ifndef WILDCARDMASK_HPP
+# define WILDCARDMASK_HPP
+
+# include "Utils.hpp"
+
+// '*'（0文字以上）と '?'（1文字）を含むマスクを事前に解析した照合器
+// 照合はRFC1459のcasemappingで大文字小文字を区別しない
+class WildcardMask {
+private:
+    std::string     _pattern;       // casefold済み、連続する'*'は1つにまとめる
+    std::string     _prefix;        // 最初のワイルドカードまでのリテラル部分（前方一致での絞り込み用）
+    std::string     _suffix;        // 最後のワイルドカードより後のリテラル部分（後方一致での絞り込み用）
+    size_t          _minLength;     // 一致に必要な最小文字数（'*'以外の文字数）
+    bool            _hasWildcard;
+
+public:
+    WildcardMask();
+    explicit WildcardMask(const std::string& mask);
+
+    void                compile(const std::string& mask);
+    bool                matches(const std::string& text) const;
+
+    const std::string&  getPattern() const;
+    const std::string&  getPrefix() const;
+    const std::string&  getSuffix() const;
+    bool                hasWildcard() const;
+    size_t              getMemoryUsage() const;     // 解析結果の文字列が持つヒープ領域
+    bool                matchesEverything() const;
+};
+
+#endif
@@ -14,6 +14,7 @@
 # define JANKENBOT_HPP
 
 # include "Bot.hpp"
+# include "../TimerWheel.hpp"
 # include <map>
 
 // じゃんけんの手
@@ -36,10 +37,12 @@ struct JankenGame {
 };
 
 // じゃんけんBot
-class JankenBot : public Bot {
+class JankenBot : public Bot, public TimerHandler {
 private:
     std::map<std::string, JankenGame>  _games;  // プレイヤーごとのゲーム状態
     std::map<std::string, int>         _stats;  // 統計情報（勝利数）
+    std::map<std::string, Timer*>      _gameTimers; // プレイヤーごとのゲーム期限
+    static const time_t                GAME_TIMEOUT = 300; // 5分で非アクティブなゲームを削除
 
     // ヘルパーメソッド
     JankenHand      parseHand(const std::string& hand) const;
@@ -52,7 +55,8 @@ private:
     void            showHelp(Client* player);
     void            showStats(Client* player);
     void            resetGame(Client* player);
-    void            cleanupInactiveGames();
+    void            scheduleGameExpiry(const std::string& nickname);
+    void            removeGameTimer(const std::string& nickname);
 
 public:
     JankenBot(Server* server);
@@ -63,6 +67,9 @@ public:
     void    onPrivateMessage(Client* sender, const std::string& message);
     void    onChannelMessage(Client* sender, const std::string& channel, const std::string& message);
     void    onJoin(Client* client, const std::string& channel);
+
+    // 非アクティブなゲームの期限切れ処理
+    void    onTimer(Timer& timer);
 };
 
 #endif
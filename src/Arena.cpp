@@ -0,0 +1,90 @@
+#include "../include/Arena.hpp"
+
+// 割り当ての境界（ポインタやsize_tを置いても問題ないように）
+static const size_t ARENA_ALIGNMENT = sizeof(void*) * 2;
+
+static size_t alignUp(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+Arena::Arena(size_t initialSize)
+    : _current(0), _offset(0), _used(0), _highWater(0), _reserved(0)
+{
+    addChunk(initialSize);
+}
+
+Arena::~Arena() {
+    for (size_t i = 0; i < _chunks.size(); ++i) {
+        delete[] _chunks[i].data;
+    }
+}
+
+void Arena::addChunk(size_t minimum) {
+    Chunk chunk;
+    chunk.size = std::max(alignUp(minimum), (size_t)ARENA_CHUNK_SIZE);
+    chunk.data = new char[chunk.size];
+    _chunks.push_back(chunk);
+    _reserved += chunk.size;
+}
+
+void* Arena::allocate(size_t size) {
+    size = alignUp(size == 0 ? 1 : size);
+
+    // 現在のチャンクに収まらなければ次のチャンクへ（足りなければ追加）
+    while (_offset + size > _chunks[_current].size) {
+        if (_current + 1 >= _chunks.size()) {
+            addChunk(size);
+        }
+        _current++;
+        _offset = 0;
+    }
+
+    void* pointer = _chunks[_current].data + _offset;
+    _offset += size;
+    _used += size;
+    return pointer;
+}
+
+char* Arena::copy(const char* data, size_t length) {
+    char* buffer = static_cast<char*>(allocate(length + 1));
+    memcpy(buffer, data, length);
+    buffer[length] = '\0';
+    return buffer;
+}
+
+void Arena::reset() {
+    if (_used > _highWater) {
+        _highWater = _used;
+    }
+
+    // 複数チャンクにまたがったら、次回から1チャンクで済むようにまとめ直す
+    if (_chunks.size() > 1) {
+        size_t total = _reserved;
+        for (size_t i = 0; i < _chunks.size(); ++i) {
+            delete[] _chunks[i].data;
+        }
+        _chunks.clear();
+        _reserved = 0;
+        addChunk(total);
+    }
+
+    _current = 0;
+    _offset = 0;
+    _used = 0;
+}
+
+size_t Arena::getUsed() const {
+    return _used;
+}
+
+size_t Arena::getHighWater() const {
+    return std::max(_highWater, _used);
+}
+
+size_t Arena::getReserved() const {
+    return _reserved;
+}
+
+size_t Arena::getChunkCount() const {
+    return _chunks.size();
+}
@@ -1,20 +1,28 @@
 #include "../include/Channel.hpp"
+#include "../include/Server.hpp"
 
-Channel::Channel(const std::string& name, Client* creator)
-    : _name(name), _inviteOnly(false), _topicRestricted(true), _userLimit(0),
-      _hasUserLimit(false), _creationTime(time(NULL))
+size_t Channel::_heapTotal = 0;
+
+Channel::Channel(const std::string& name, NameId id, Server* server, Client* creator)
+    : _name(name), _id(id), _server(server), _inviteOnly(false), _topicRestricted(true), _userLimit(0),
+      _hasUserLimit(false), _creationTime(time(NULL)), _heapAccounted(0)
 {
     if (creator) {
-        _clients.push_back(creator);
-        _operators.push_back(creator->getNickname());
+        ChannelMember member;
+        member.client = creator;
+        member.modes = MEMBER_OPERATOR;
+        _memberIndex.insert(creator, _members.insert(_members.end(), member));
+        creator->addChannel(this);
 
         std::cout << "\033[1;33m[CHANNEL] Created " << name << " with creator "
                   << creator->getNickname() << " as operator\033[0m" << std::endl;
     }
+    accountMemory();
 }
 
 Channel::~Channel() {
-    // メモリ管理はサーバークラスで行うため、ここでは特に何もしない
+    // メモリ管理はサーバークラスで行うため、ここでは集計から外すだけ
+    _heapTotal -= _heapAccounted;
     std::cout << "\033[1;33m[CHANNEL] Destroying channel " << _name << "\033[0m" << std::endl;
 }
 
@@ -23,6 +31,10 @@ std::string Channel::getName() const {
     return _name;
 }
 
+NameId Channel::getId() const {
+    return _id;
+}
+
 std::string Channel::getTopic() const {
     return _topic;
 }
@@ -32,7 +44,16 @@ std::string Channel::getKey() const {
 }
 
 std::vector<Client*> Channel::getClients() const {
-    return _clients;
+    std::vector<Client*> clients;
+    clients.reserve(_members.size());
+    for (MemberList::const_iterator it = _members.begin(); it != _members.end(); ++it) {
+        clients.push_back(it->client);
+    }
+    return clients;
+}
+
+const MemberList& Channel::getMembers() const {
+    return _members;
 }
 
 bool Channel::isInviteOnly() const {
@@ -63,6 +84,7 @@ time_t Channel::getCreationTime() const {
 void Channel::setTopic(const std::string& topic) {
     std::string oldTopic = _topic;
     _topic = topic;
+    accountMemory();
 
     std::cout << "\033[1;33m[CHANNEL] " << _name << " topic changed";
     if (oldTopic.empty()) {
@@ -76,6 +98,7 @@ void Channel::setTopic(const std::string& topic) {
 void Channel::setKey(const std::string& key) {
     bool hadKey = hasKey();
     _key = key;
+    accountMemory();
 
     if (key.empty() && hadKey) {
         std::cout << "\033[1;33m[CHANNEL] " << _name << " key removed\033[0m" << std::endl;
@@ -139,6 +162,13 @@ bool Channel::addClient(Client* client, const std::string& key) {
         return false;
     }
 
+    // BANされている場合は拒否（+eに一致すれば通す）
+    if (isBanned(client)) {
+        std::cout << "\033[1;33m[CHANNEL] " << _name << " access denied for "
+                  << client->getNickname() << ": banned\033[0m" << std::endl;
+        return false;
+    }
+
     // キーが設定されている場合はチェック
     if (hasKey() && key != _key) {
         std::cout << "\033[1;33m[CHANNEL] " << _name << " access denied for "
@@ -147,37 +177,41 @@ bool Channel::addClient(Client* client, const std::string& key) {
     }
 
     // 招待制の場合は招待されているかチェック
-    if (_inviteOnly && !isInvited(client->getNickname())) {
+    if (_inviteOnly && !canJoinWithoutInvite(client)) {
         std::cout << "\033[1;33m[CHANNEL] " << _name << " access denied for "
                   << client->getNickname() << ": not invited\033[0m" << std::endl;
         return false;
     }
 
     // ユーザー数制限チェック
-    if (_hasUserLimit && _clients.size() >= _userLimit) {
+    if (_hasUserLimit && _members.size() >= _userLimit) {
         std::cout << "\033[1;33m[CHANNEL] " << _name << " access denied for "
-                  << client->getNickname() << ": channel full (" << _clients.size()
+                  << client->getNickname() << ": channel full (" << _members.size()
                   << "/" << _userLimit << ")\033[0m" << std::endl;
         return false;
     }
 
     // 過剰なクライアント数のチェック（実装上の制限）
     const size_t MAX_CLIENTS_PER_CHANNEL = 200;
-    if (_clients.size() >= MAX_CLIENTS_PER_CHANNEL) {
+    if (_members.size() >= MAX_CLIENTS_PER_CHANNEL) {
         std::cout << "\033[1;31m[ERROR] Channel " << _name << " has reached maximum capacity ("
                   << MAX_CLIENTS_PER_CHANNEL << " clients)\033[0m" << std::endl;
         return false;
     }
 
-    // クライアントを追加
-    _clients.push_back(client);
-    client->addChannel(_name);
+    // クライアントを追加（参加順の末尾に置き、索引に登録）
+    ChannelMember member;
+    member.client = client;
+    member.modes = 0;
+    _memberIndex.insert(client, _members.insert(_members.end(), member));
+    client->addChannel(this);
+    accountMemory();
 
     // 招待リストから削除
     removeInvite(client->getNickname());
 
     std::cout << "\033[1;32m[CHANNEL] " << client->getNickname() << " joined " << _name
-              << " (total users: " << _clients.size() << ")\033[0m" << std::endl;
+              << " (total users: " << _members.size() << ")\033[0m" << std::endl;
     return true;
 }
 
@@ -188,82 +222,187 @@ void Channel::removeClient(Client* client) {
         return;
     }
 
-    // クライアントをチャンネルから削除
-    std::vector<Client*>::iterator it = std::find(_clients.begin(), _clients.end(), client);
-    if (it != _clients.end()) {
-        std::string nickname = client->getNickname(); // 先にニックネームを取得
-        _clients.erase(it);
+    // クライアントをチャンネルから削除（モードも同時に消える）
+    MemberList::iterator* entry = _memberIndex.find(client);
+    if (entry) {
+        bool wasOperator = ((*entry)->modes & MEMBER_OPERATOR) != 0;
+        _members.erase(*entry);
+        _memberIndex.erase(client);
+        client->removeChannel(this);
+        accountMemory();
 
         std::cout << "\033[1;31m[CHANNEL] Client left " << _name
-                  << " (total users: " << _clients.size() << ")\033[0m" << std::endl;
+                  << " (total users: " << _members.size() << ")\033[0m" << std::endl;
 
-        // オペレータからも削除（先に取得したニックネームを使用）
-        if (!nickname.empty()) {
-            removeOperator(nickname);
+        if (wasOperator) {
+            std::cout << "\033[1;35m[CHANNEL] " << client->getNickname() << " is no longer an operator in " << _name << "\033[0m" << std::endl;
+        }
+
+        // 最後の参加者が抜けたらその場で破棄する（呼び出し側はこの後チャンネルに触れないこと）
+        if (_members.empty() && _server) {
+            _server->destroyChannel(this);
         }
     }
 }
 
-bool Channel::isClientInChannel(Client* client) const {
-    return std::find(_clients.begin(), _clients.end(), client) != _clients.end();
+bool Channel::isClientInChannel(const Client* client) const {
+    return _memberIndex.contains(client);
 }
 
-bool Channel::isClientInChannel(const std::string& nickname) const {
-    for (std::vector<Client*>::const_iterator it = _clients.begin(); it != _clients.end(); ++it) {
-        if ((*it)->getNickname() == nickname) {
-            return true;
-        }
+// メンバーモード管理
+bool Channel::hasMemberMode(const Client* client, unsigned char mode) const {
+    const MemberList::iterator* entry = _memberIndex.find(client);
+    return entry && ((*entry)->modes & mode) != 0;
+}
+
+bool Channel::setMemberMode(const Client* client, unsigned char mode, bool set) {
+    MemberList::iterator* entry = _memberIndex.find(client);
+    if (!entry) {
+        return false;
     }
-    return false;
+    if (set) {
+        (*entry)->modes |= mode;
+    } else {
+        (*entry)->modes &= ~mode;
+    }
+    return true;
 }
 
-// オペレータ管理
-bool Channel::isOperator(const std::string& nickname) const {
-    return std::find(_operators.begin(), _operators.end(), nickname) != _operators.end();
+bool Channel::isOperator(const Client* client) const {
+    return hasMemberMode(client, MEMBER_OPERATOR);
 }
 
-void Channel::addOperator(const std::string& nickname) {
-    if (!isOperator(nickname)) {
-        _operators.push_back(nickname);
-        std::cout << "\033[1;35m[CHANNEL] " << nickname << " is now an operator in " << _name << "\033[0m" << std::endl;
+void Channel::addOperator(const Client* client) {
+    if (!isOperator(client) && setMemberMode(client, MEMBER_OPERATOR, true)) {
+        std::cout << "\033[1;35m[CHANNEL] " << client->getNickname() << " is now an operator in " << _name << "\033[0m" << std::endl;
     }
 }
 
-void Channel::removeOperator(const std::string& nickname) {
-    std::vector<std::string>::iterator it = std::find(_operators.begin(), _operators.end(), nickname);
-    if (it != _operators.end()) {
-        _operators.erase(it);
-        std::cout << "\033[1;35m[CHANNEL] " << nickname << " is no longer an operator in " << _name << "\033[0m" << std::endl;
+void Channel::removeOperator(const Client* client) {
+    if (isOperator(client) && setMemberMode(client, MEMBER_OPERATOR, false)) {
+        std::cout << "\033[1;35m[CHANNEL] " << client->getNickname() << " is no longer an operator in " << _name << "\033[0m" << std::endl;
     }
 }
 
+// NAMES/WHOで表示する接頭辞（@: オペレータ、+: ボイス）
+std::string Channel::getMemberPrefix(const ChannelMember& member) const {
+    if (member.modes & MEMBER_OPERATOR) {
+        return "@";
+    }
+    if (member.modes & MEMBER_VOICE) {
+        return "+";
+    }
+    return "";
+}
+
+std::string Channel::getMemberPrefix(const Client* client) const {
+    const MemberList::iterator* entry = _memberIndex.find(client);
+    return entry ? getMemberPrefix(**entry) : "";
+}
+
 // 招待管理
 void Channel::inviteUser(const std::string& nickname) {
     if (!isInvited(nickname)) {
-        _invitedUsers.push_back(nickname);
+        _invitedUsers.push_back(NameTable::casefold(nickname));
+        accountMemory();
         std::cout << "\033[1;33m[CHANNEL] " << nickname << " was invited to " << _name << "\033[0m" << std::endl;
     }
 }
 
 bool Channel::isInvited(const std::string& nickname) const {
-    return std::find(_invitedUsers.begin(), _invitedUsers.end(), nickname) != _invitedUsers.end();
+    return std::find(_invitedUsers.begin(), _invitedUsers.end(), NameTable::casefold(nickname)) != _invitedUsers.end();
 }
 
 void Channel::removeInvite(const std::string& nickname) {
-    std::vector<std::string>::iterator it = std::find(_invitedUsers.begin(), _invitedUsers.end(), nickname);
+    std::vector<std::string>::iterator it = std::find(_invitedUsers.begin(), _invitedUsers.end(), NameTable::casefold(nickname));
     if (it != _invitedUsers.end()) {
         _invitedUsers.erase(it);
+        accountMemory();
         std::cout << "\033[1;33m[CHANNEL] Removed " << nickname << " from " << _name << " invite list\033[0m" << std::endl;
     }
 }
 
+// マスクリスト管理
+bool Channel::isBanned(const Client* client) const {
+    // 空のリストは索引も引かずに抜ける
+    if (_bans.empty() || !_bans.matches(client)) {
+        return false;
+    }
+    return !_exceptions.matches(client);
+}
+
+bool Channel::canJoinWithoutInvite(const Client* client) const {
+    return isInvited(client->getNickname()) || _inviteExceptions.matches(client);
+}
+
+bool Channel::canSpeak(const Client* client) const {
+    if (hasMemberMode(client, MEMBER_OPERATOR | MEMBER_VOICE)) {
+        return true;
+    }
+    return !isBanned(client);
+}
+
+MaskList* Channel::getMaskList(char mode) {
+    switch (mode) {
+        case 'b': return &_bans;
+        case 'e': return &_exceptions;
+        case 'I': return &_inviteExceptions;
+        default: return NULL;
+    }
+}
+
+void Channel::sendMaskList(Client* client, char mode) const {
+    const MaskList* list = NULL;
+    int entryReply = 0;
+    int endReply = 0;
+    std::string endText;
+
+    switch (mode) {
+        case 'b':
+            list = &_bans;
+            entryReply = RPL_BANLIST;
+            endReply = RPL_ENDOFBANLIST;
+            endText = "End of channel ban list";
+            break;
+        case 'e':
+            list = &_exceptions;
+            entryReply = RPL_EXCEPTLIST;
+            endReply = RPL_ENDOFEXCEPTLIST;
+            endText = "End of channel exception list";
+            break;
+        case 'I':
+            list = &_inviteExceptions;
+            entryReply = RPL_INVITELIST;
+            endReply = RPL_ENDOFINVITELIST;
+            endText = "End of channel invite list";
+            break;
+        default:
+            return;
+    }
+
+    // <channel> <mask> <setter> <time>
+    const std::vector<MaskEntry>& entries = list->getEntries();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        std::ostringstream line;
+        line << _name << " " << entries[i].mask << " " << entries[i].setBy << " " << entries[i].setAt;
+        client->sendNumericReply(entryReply, line.str());
+    }
+    client->sendNumericReply(endReply, _name + " :" + endText);
+}
+
 // メッセージ送信
 void Channel::broadcastMessage(const std::string& message, Client* exclude) {
     std::cout << "\033[1;34m[BROADCAST] To channel " << _name << ": " << message << "\033[0m" << std::endl;
 
-    for (std::vector<Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
-        if (*it != exclude) {
-            (*it)->sendMessage(message);
+    // 1回だけ整形し、全メンバーで同じバッファを共有する
+    broadcastMessage(SharedMessage(message), exclude);
+}
+
+void Channel::broadcastMessage(const SharedMessage& message, Client* exclude) {
+    // 各メンバーへは参照を積むだけ（送信キューの上限を超えたメンバーはsendMessage側で切り離される）
+    for (MemberList::iterator it = _members.begin(); it != _members.end(); ++it) {
+        if (it->client != exclude) {
+            it->client->sendMessage(message);
         }
     }
 }
@@ -271,12 +410,9 @@ void Channel::broadcastMessage(const std::string& message, Client* exclude) {
 void Channel::sendNames(Client* client) {
     std::string namesList;
 
-    for (std::vector<Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
-        if (isOperator((*it)->getNickname())) {
-            namesList += "@" + (*it)->getNickname() + " ";
-        } else {
-            namesList += (*it)->getNickname() + " ";
-        }
+    // 参加順に、モードに応じた接頭辞を付けて並べる
+    for (MemberList::iterator it = _members.begin(); it != _members.end(); ++it) {
+        namesList += getMemberPrefix(*it) + it->client->getNickname() + " ";
     }
 
     client->sendNumericReply(RPL_NAMREPLY, "= " + _name + " :" + namesList);
@@ -303,7 +439,7 @@ std::string Channel::getModes() const {
     return modes;
 }
 
-bool Channel::applyMode(char mode, bool set, const std::string& param, Client* client) {
+bool Channel::applyMode(char mode, bool set, const std::string& param, Client* client, Client* target) {
     std::string clientNick = client ? client->getNickname() : "Unknown";
 
     switch (mode) {
@@ -334,11 +470,12 @@ bool Channel::applyMode(char mode, bool set, const std::string& param, Client* c
             break;
 
         case 'o': // オペレータ権限
+        case 'v': // ボイス
             if (!param.empty()) {
-                // ユーザーがチャンネルに参加しているか確認
-                if (!isClientInChannel(param)) {
+                // ユーザーがチャンネルに参加しているか確認（targetは呼び出し側でニックネームから解決済み）
+                if (!target || !isClientInChannel(target)) {
                     std::cout << "\033[1;31m[MODE] " << clientNick << " tried to set " << _name
-                              << " mode " << (set ? "+" : "-") << "o for " << param
+                              << " mode " << (set ? "+" : "-") << mode << " for " << param
                               << " but user is not in channel\033[0m" << std::endl;
 
                     // クライアントがnullでない場合にエラーメッセージを送信
@@ -352,15 +489,45 @@ bool Channel::applyMode(char mode, bool set, const std::string& param, Client* c
                     return false;
                 }
 
-                if (set) {
-                    addOperator(param);
-                    std::cout << "\033[1;33m[MODE] " << clientNick << " set " << _name
-                              << " mode +o " << param << "\033[0m" << std::endl;
+                if (mode == 'o') {
+                    if (set) {
+                        addOperator(target);
+                    } else {
+                        removeOperator(target);
+                    }
                 } else {
-                    removeOperator(param);
-                    std::cout << "\033[1;33m[MODE] " << clientNick << " set " << _name
-                              << " mode -o " << param << "\033[0m" << std::endl;
+                    setMemberMode(target, MEMBER_VOICE, set);
+                }
+                std::cout << "\033[1;33m[MODE] " << clientNick << " set " << _name
+                          << " mode " << (set ? "+" : "-") << mode << " " << param << "\033[0m" << std::endl;
+                return true;
+            }
+            break;
+
+        case 'b': // BAN
+        case 'e': // BAN除外
+        case 'I': // 招待除外
+            if (!param.empty()) {
+                MaskList* list = getMaskList(mode);
+                if (set) {
+                    if (list->contains(param)) {
+                        return false;
+                    }
+                    if (list->size() >= MAX_CHANNEL_MASKS) {
+                        std::cout << "\033[1;31m[MODE] " << _name << " +" << mode << " list is full ("
+                                  << MAX_CHANNEL_MASKS << " entries)\033[0m" << std::endl;
+                        if (client) {
+                            client->sendNumericReply(ERR_BANLISTFULL, _name + " " + mode + " :Channel list is full");
+                        }
+                        return false;
+                    }
+                    list->add(param, clientNick);
+                } else if (!list->remove(param)) {
+                    return false;
                 }
+                accountMemory();
+                std::cout << "\033[1;33m[MODE] " << clientNick << " set " << _name
+                          << " mode " << (set ? "+" : "-") << mode << " " << MaskList::normalize(param) << "\033[0m" << std::endl;
                 return true;
             }
             break;
@@ -405,5 +572,29 @@ bool Channel::applyMode(char mode, bool set, const std::string& param, Client* c
 
 // ユーティリティ
 size_t Channel::getClientCount() const {
-    return _clients.size();
+    return _members.size();
+}
+
+// 参加者リストのノード、索引、招待リスト、マスクリストなどスロット外のヒープ領域
+size_t Channel::getHeapUsage() const {
+    size_t total = _name.capacity() + _topic.capacity() + _key.capacity()
+                 + _members.size() * (sizeof(ChannelMember) + 2 * sizeof(void*))
+                 + _memberIndex.getMemoryUsage()
+                 + _invitedUsers.capacity() * sizeof(std::string)
+                 + _bans.getMemoryUsage() + _exceptions.getMemoryUsage() + _inviteExceptions.getMemoryUsage();
+    for (size_t i = 0; i < _invitedUsers.size(); ++i) {
+        total += _invitedUsers[i].capacity();
+    }
+    return total;
+}
+
+// 変更のあった構造のサイズを計り直し、差分だけ全体の集計に反映する
+void Channel::accountMemory() {
+    size_t usage = getHeapUsage();
+    _heapTotal = _heapTotal - _heapAccounted + usage;
+    _heapAccounted = usage;
+}
+
+size_t Channel::getHeapTotal() {
+    return _heapTotal;
 }
@@ -1,12 +1,40 @@
 #include "../include/Client.hpp"
-
-Client::Client(int fd, const std::string& hostname)
-    : _fd(fd), _hostname(hostname), _status(CONNECTING), _passAccepted(false),
-      _operator(false), _away(false) {
+#include "../include/Server.hpp"
+#include "../include/LineScanner.hpp"
+
+size_t Client::_heapTotal = 0;
+
+Client::Client(int fd, const std::string& hostname, Server* server)
+    : _fd(fd), _nickId(INVALID_NAME_ID), _hostname(hostname), _status(CONNECTING), _passAccepted(false),
+      _operator(false), _away(false), _server(server), _sendOffset(0), _sendQueueBytes(0),
+      _flushScheduled(false), _disconnectPending(false), _recvStart(0), _recvEnd(0), _recvScan(0),
+      _recvSpecial(false), _discardingLine(false), _sendQExceeded(false), _sendQAboveSince(0),
+      _floodRefillMs(0), _floodHeld(false), _runQueued(false), _runQueuedMs(0), _readPaused(false), _inputScore(0),
+      _heapAccounted(0) {
     _lastActivity = time(NULL);
+    _connectTime = _lastActivity;
+    _inputScoreTime = _lastActivity;
+    _pingSentAt = 0;
+    _pingSentMs = 0;
+    _lastRttMs = -1;
+    _floodTokens = 0;
+
+    // 登録タイムアウト/キープアライブの初回確認を設定（以降は満了時に期限を計算し直す）
+    if (_server) {
+        _idleTimer.setHandler(this);
+        time_t firstCheck = std::min((time_t)REGISTRATION_TIMEOUT, (time_t)_server->getPingInterval());
+        _server->getTimers().schedule(_idleTimer, firstCheck * 1000UL);
+        _floodTimer.setHandler(this);
+        _sendQTimer.setHandler(this);
+        _floodTokens = _server->getFloodBurst() * 1000UL;
+        _floodRefillMs = TimerWheel::nowMs();
+    }
+    accountMemory();
 }
 
 Client::~Client() {
+    _heapTotal -= _heapAccounted;
+
     // ソケットを閉じる
     if (_fd >= 0) {
         close(_fd);
@@ -23,6 +51,10 @@ std::string Client::getNickname() const {
     return _nickname;
 }
 
+NameId Client::getNickId() const {
+    return _nickId;
+}
+
 std::string Client::getUsername() const {
     return _username;
 }
@@ -59,7 +91,7 @@ std::string Client::getAwayMessage() const {
     return _awayMessage;
 }
 
-std::vector<std::string> Client::getChannels() const {
+const std::vector<NameId>& Client::getChannels() const {
     return _channels;
 }
 
@@ -69,6 +101,10 @@ std::string Client::getPrefix() const {
 }
 
 // セッター
+void Client::setNickId(NameId id) {
+    _nickId = id;
+}
+
 void Client::setNickname(const std::string& nickname) {
     // ニックネームのバリデーション
     if (nickname.empty()) {
@@ -92,6 +128,7 @@ void Client::setNickname(const std::string& nickname) {
     }
 
     _nickname = nickname;
+    accountMemory();
 }
 
 void Client::setUsername(const std::string& username) {
@@ -111,6 +148,7 @@ void Client::setUsername(const std::string& username) {
     }
 
     _username = username;
+    accountMemory();
 }
 
 void Client::setRealname(const std::string& realname) {
@@ -118,10 +156,10 @@ void Client::setRealname(const std::string& realname) {
     if (realname.length() > 100) {
         std::cout << "\033[1;33m[WARNING] Truncating realname to 100 characters\033[0m" << std::endl;
         _realname = realname.substr(0, 100);
-        return;
+    } else {
+        _realname = realname;
     }
-
-    _realname = realname;
+    accountMemory();
 }
 
 void Client::setStatus(ClientStatus status) {
@@ -193,6 +231,7 @@ void Client::setAway(bool away, const std::string& message) {
     bool oldValue = _away;
     _away = away;
     _awayMessage = truncatedMessage;
+    accountMemory();
 
     // 値が変わった場合だけログを出力
     if (oldValue != away) {
@@ -209,185 +248,525 @@ void Client::setAway(bool away, const std::string& message) {
 }
 
 // チャンネル管理
-void Client::addChannel(const std::string& channel) {
-    // チャンネル名のバリデーション
-    if (channel.empty() || channel[0] != CHANNEL_PREFIX) {
-        std::cout << "\033[1;31m[ERROR] Invalid channel name: " << channel << "\033[0m" << std::endl;
-        return;
-    }
-
+void Client::addChannel(const Channel* channel) {
     // 重複チェック
-    if (!isInChannel(channel)) {
-        _channels.push_back(channel);
+    if (!isInChannel(channel->getId())) {
+        _channels.push_back(channel->getId());
+        accountMemory();
 
         std::cout << "\033[1;33m[CHANNEL] Client " << _fd;
         if (!_nickname.empty()) {
             std::cout << " (" << _nickname << ")";
         }
-        std::cout << " joined channel " << channel << "\033[0m" << std::endl;
+        std::cout << " joined channel " << channel->getName() << "\033[0m" << std::endl;
     }
 }
 
-void Client::removeChannel(const std::string& channel) {
-    std::vector<std::string>::iterator it = std::find(_channels.begin(), _channels.end(), channel);
+void Client::removeChannel(const Channel* channel) {
+    std::vector<NameId>::iterator it = std::find(_channels.begin(), _channels.end(), channel->getId());
     if (it != _channels.end()) {
         _channels.erase(it);
+        accountMemory();
 
         std::cout << "\033[1;33m[CHANNEL] Client " << _fd;
         if (!_nickname.empty()) {
             std::cout << " (" << _nickname << ")";
         }
-        std::cout << " left channel " << channel << "\033[0m" << std::endl;
+        std::cout << " left channel " << channel->getName() << "\033[0m" << std::endl;
     }
 }
 
-bool Client::isInChannel(const std::string& channel) const {
-    return std::find(_channels.begin(), _channels.end(), channel) != _channels.end();
+bool Client::isInChannel(NameId channelId) const {
+    return std::find(_channels.begin(), _channels.end(), channelId) != _channels.end();
 }
 
 // バッファ操作
-void Client::appendToBuffer(const std::string& data) {
-    // データサイズの制限チェック（DoS対策）
-    if (_buffer.length() > 4096) {
-        std::cout << "\033[1;31m[WARNING] Buffer overflow from client " << _fd << ", clearing buffer\033[0m" << std::endl;
-        _buffer.clear();
-    }
-
-    // エスケープシーケンスを検出してフィルタリング
-    std::string filtered;
-    for (size_t i = 0; i < data.length(); i++) {
-        // エスケープシーケンス（矢印キーなど）の開始
-        if (data[i] == '\033') {
-            // 矢印キーなどのエスケープシーケンスをスキップ
-            // 典型的なエスケープシーケンスは \033[A (上矢印) のような形式
-            while (i < data.length() &&
-                  !(data[i] >= 'A' && data[i] <= 'Z') &&
-                  !(data[i] >= 'a' && data[i] <= 'z')) {
-                i++;
-            }
-            // 終端文字もスキップ
-            if (i < data.length()) {
-                i++;
-            }
-            continue;
-        }
-
-        // 通常の文字なら追加
-        if (data[i] != '\0') { // NULL文字をフィルタリング
-            filtered += data[i];
-        }
+size_t Client::prepareRecv(char*& space) {
+    // 未処理データがなければ先頭から使い直す
+    if (_recvStart == _recvEnd) {
+        _recvStart = 0;
+        _recvEnd = 0;
+        _recvScan = 0;
+        _recvSpecial = false;
+    } else if (_recvStart > 0 && RECV_BUFFER_SIZE - _recvEnd < RECV_BUFFER_SIZE / 2) {
+        // 末尾の空きが少なければ途中の行（MAX_INPUT_LINE以下）だけを先頭に詰める
+        size_t pending = _recvEnd - _recvStart;
+        memmove(_recvBuffer, _recvBuffer + _recvStart, pending);
+        _recvScan -= _recvStart;
+        _recvStart = 0;
+        _recvEnd = pending;
     }
 
-    _buffer += filtered;
+    space = _recvBuffer + _recvEnd;
+    return RECV_BUFFER_SIZE - _recvEnd;
+}
+
+void Client::commitRecv(size_t length) {
+    _recvEnd += length;
     updateLastActivity();
+
+    // 受信量を記録（古い分は1秒ごとに半減させる）
+    _inputScore = getInputScore() + length;
+    _inputScoreTime = _lastActivity;
 }
 
-std::string Client::getBuffer() const {
-    return _buffer;
+bool Client::isReadPaused() const {
+    return _readPaused;
 }
 
-void Client::clearBuffer() {
-    _buffer.clear();
+void Client::setReadPaused(bool paused) {
+    _readPaused = paused;
 }
 
-std::vector<std::string> Client::getCompleteMessages() {
-    std::vector<std::string> messages;
-    size_t pos = 0;
-    size_t found;
+unsigned long Client::getInputScore() const {
+    time_t elapsed = time(NULL) - _inputScoreTime;
+    if (elapsed <= 0) {
+        return _inputScore;
+    }
+    if (elapsed >= (time_t)(sizeof(unsigned long) * 8)) {
+        return 0;
+    }
+    return _inputScore >> elapsed;
+}
+
+size_t Client::appendInput(const char* data, size_t length) {
+    // io_uringのprovided bufferなど、外部バッファから受け取る場合
+    char* space;
+    size_t available = prepareRecv(space);
+    size_t copied = std::min(available, length);
+    memcpy(space, data, copied);
+    commitRecv(copied);
+    return copied;
+}
+
+// 直前にnextLineで取り出した行を未処理に戻す（トークン不足で後回しにする場合）
+// \rや除去したESC/NULの分だけ行を後ろにずらし、改行の直前に詰め直す
+void Client::deferLine(const char* line, size_t length) {
+    size_t newline = _recvStart - 1;
+    memmove(_recvBuffer + newline - length, line, length);
+    _recvStart = newline - length;
+    _recvScan = _recvStart;
+    _recvSpecial = false;
+}
+
+void Client::stashInput(const char* data, size_t length) {
+    _recvBacklog.append(data, length);
+    accountMemory();
+}
 
-    // バッファが大きすぎる場合は切り詰める（DoS対策）
-    if (_buffer.length() > 8192) {
-        std::cout << "\033[1;31m[WARNING] Buffer too large (" << _buffer.length()
-                  << " bytes) from client " << _fd << ", truncating\033[0m" << std::endl;
-        _buffer = _buffer.substr(0, 8192);
+// 受信バッファの空きに入るだけ取り出す
+void Client::refillFromBacklog() {
+    if (_recvBacklog.empty()) {
+        return;
+    }
+    char* space;
+    size_t available = prepareRecv(space);
+    size_t copied = std::min(available, _recvBacklog.size());
+    memcpy(space, _recvBacklog.data(), copied);
+    _recvBacklog.erase(0, copied);
+    if (_recvBacklog.empty()) {
+        // 一時的に膨らんだ領域を手放す
+        std::string().swap(_recvBacklog);
     }
+    commitRecv(copied);
+    accountMemory();
+}
 
-    // \r\n または \n のいずれかで区切られた完全なメッセージを検索
-    while (true) {
-        // まず\r\nを探す
-        found = _buffer.find("\r\n", pos);
-        if (found != std::string::npos) {
-            std::string message = _buffer.substr(pos, found - pos);
-
-            // メッセージが空でない場合のみ追加
-            if (!message.empty()) {
-                messages.push_back(message);
-            }
+bool Client::hasBacklog() const {
+    return !_recvBacklog.empty();
+}
+
+// 未処理データが受信バッファ全体を占めていなければ空きがある（prepareRecvが詰め直して空きを作れる）
+bool Client::hasRecvSpace() const {
+    return _recvEnd - _recvStart < RECV_BUFFER_SIZE;
+}
+
+bool Client::isRunQueued() const {
+    return _runQueued;
+}
+
+unsigned long long Client::getRunQueuedMs() const {
+    return _runQueuedMs;
+}
 
-            pos = found + 2; // \r\nの長さ分進める
+void Client::setRunQueued(bool queued, unsigned long long nowMs) {
+    _runQueued = queued;
+    _runQueuedMs = nowMs;
+}
+
+// トークンバケット: 経過時間に応じて補充し、足りればcost分を消費する
+bool Client::consumeFloodTokens(unsigned cost) {
+    if (!_server) {
+        return true;
+    }
+    unsigned long capacity = _server->getFloodBurst() * 1000UL;
+    unsigned long long now = TimerWheel::nowMs();
+    unsigned long long refill = (now - _floodRefillMs) * _server->getFloodRate();
+    _floodTokens = (unsigned long)std::min((unsigned long long)capacity, _floodTokens + refill);
+    _floodRefillMs = now;
+
+    // バケットより重いコマンドも満杯なら実行できるようにする
+    unsigned long needed = std::min(capacity, cost * 1000UL);
+    if (_floodTokens < needed) {
+        return false;
+    }
+    _floodTokens -= needed;
+    return true;
+}
+
+// costを払えるだけトークンが貯まる時刻にタイマーを設定して入力を保留
+void Client::holdInput(unsigned cost) {
+    unsigned long capacity = _server->getFloodBurst() * 1000UL;
+    unsigned long needed = std::min(capacity, cost * 1000UL);
+    unsigned long rate = _server->getFloodRate();
+    unsigned long waitMs = (needed - std::min(needed, _floodTokens) + rate - 1) / rate;
+    _floodHeld = true;
+    _server->getTimers().schedule(_floodTimer, std::max(waitMs, 1UL));
+}
+
+void Client::releaseInput() {
+    _floodHeld = false;
+    _floodTimer.cancel();
+}
+
+bool Client::isFloodHeld() const {
+    return _floodHeld;
+}
+
+bool Client::wantsInput() const {
+    // 受信バッファが満杯の間と、入りきらない分が溜まっている間も読み込みを止める
+    return !_floodHeld && !_readPaused && hasRecvSpace() && _recvBacklog.size() < RECV_BUFFER_SIZE;
+}
+
+size_t Client::filterLine(char* line, size_t length) {
+    // 矢印キーなどのエスケープシーケンス（\033[A など）とNULL文字を取り除いて詰める
+    size_t out = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (line[i] == '\033') {
+            while (i < length &&
+                  !(line[i] >= 'A' && line[i] <= 'Z') &&
+                  !(line[i] >= 'a' && line[i] <= 'z')) {
+                i++;
+            }
+            // 終端文字もスキップ（forのi++で進む）
             continue;
         }
+        if (line[i] != '\0') {
+            line[out++] = line[i];
+        }
+    }
+    return out;
+}
 
-        // \r\nがなければ\nを探す
-        found = _buffer.find("\n", pos);
-        if (found != std::string::npos) {
-            std::string message = _buffer.substr(pos, found - pos);
-            // \rを除去（\r\nの代わりに\nだけが使われる場合の対策）
-            if (!message.empty() && message[message.length() - 1] == '\r') {
-                message = message.substr(0, message.length() - 1);
+bool Client::nextLine(const char*& line, size_t& length) {
+    while (true) {
+        // 前回探索した位置から改行を探し、同じ走査でESC/NULの有無も調べる（\r\n と \n の両方に対応）
+        size_t newline = _recvScan + LineScanner::findLineEnd(_recvBuffer + _recvScan, _recvEnd - _recvScan, _recvSpecial);
+        if (newline == _recvEnd) {
+            _recvScan = _recvEnd;
+
+            // 改行のないまま上限を超えた行は残りを改行まで読み捨てる
+            if (_recvEnd - _recvStart > MAX_INPUT_LINE) {
+                if (!_discardingLine) {
+                    std::cout << "\033[1;31m[WARNING] Input line too long from client " << _fd << ", discarding\033[0m" << std::endl;
+                    sendNumericReply(ERR_INPUTTOOLONG, ":Input line was too long");
+                    _discardingLine = true;
+                }
+                _recvStart = _recvEnd;
             }
+            return false;
+        }
 
-            // メッセージが空でない場合のみ追加
-            if (!message.empty()) {
-                messages.push_back(message);
-            }
+        size_t lineStart = _recvStart;
+        size_t lineEnd = newline;
+        bool special = _recvSpecial;
+        _recvStart = lineEnd + 1;
+        _recvScan = _recvStart;
+        _recvSpecial = false;
 
-            pos = found + 1; // \nの長さ分進める
+        // 読み捨て中の行の終端
+        if (_discardingLine) {
+            _discardingLine = false;
             continue;
         }
 
-        // どちらも見つからなければループを抜ける
-        break;
-    }
+        size_t lineLength = lineEnd - lineStart;
+        if (lineLength > MAX_INPUT_LINE) {
+            std::cout << "\033[1;31m[WARNING] Input line too long from client " << _fd << ", discarding\033[0m" << std::endl;
+            sendNumericReply(ERR_INPUTTOOLONG, ":Input line was too long");
+            continue;
+        }
 
-    // 処理済みの部分をバッファから削除
-    if (pos > 0) {
-        _buffer = _buffer.substr(pos);
-    }
+        // \rを除去（\r\nの代わりに\nだけが使われる場合もある）
+        if (lineLength > 0 && _recvBuffer[lineEnd - 1] == '\r') {
+            lineLength--;
+        }
+        if (special) {
+            lineLength = filterLine(_recvBuffer + lineStart, lineLength);
+        }
 
-    // 過剰なメッセージ数の制限
-    if (messages.size() > 100) {
-        std::cout << "\033[1;31m[WARNING] Too many messages (" << messages.size()
-                  << ") from client " << _fd << ", truncating to 100\033[0m" << std::endl;
-        messages.resize(100);
-    }
+        // 空行は無視
+        if (lineLength == 0) {
+            continue;
+        }
 
-    return messages;
+        line = _recvBuffer + lineStart;
+        length = lineLength;
+        return true;
+    }
 }
 
 // メッセージ送信
 void Client::sendMessage(const std::string& message) {
     if (_fd >= 0) {
-        std::string fullMessage = message;
-
-        // メッセージが長すぎる場合は切り詰める
-        if (fullMessage.length() > 512) {
-            std::cout << "\033[1;33m[WARNING] Truncating message to 512 characters\033[0m" << std::endl;
-            fullMessage = fullMessage.substr(0, 510);
-
-            // 末尾に\r\nがない場合は追加
-            if (fullMessage.find("\r\n", fullMessage.length() - 2) == std::string::npos) {
-                fullMessage += "\r\n";
-            }
-        } else if (fullMessage.find("\r\n") == std::string::npos) {
-            fullMessage += "\r\n";
-        }
+        // 長さの制限とCRLFの付加はSharedMessageで行う
+        SharedMessage line(message);
 
         std::cout << "\033[1;34m[SEND] To fd " << _fd;
         if (!_nickname.empty()) {
             std::cout << " (" << _nickname << ")";
         }
-        std::cout << ": " << fullMessage << "\033[0m";
+        std::cout << ": ";
+        std::cout.write(line.data(), line.length());
+        std::cout << "\033[0m";
+
+        queueMessage(line);
+    } else {
+        std::cerr << "\033[1;31m[ERROR] Attempting to send message to invalid fd: " << _fd << "\033[0m" << std::endl;
+    }
+}
+
+// 整形済みの行を送信（ブロードキャスト用、内容はコピーせず参照を積む）
+void Client::sendMessage(const SharedMessage& message) {
+    if (_fd >= 0) {
+        queueMessage(message);
+    } else {
+        std::cerr << "\033[1;31m[ERROR] Attempting to send message to invalid fd: " << _fd << "\033[0m" << std::endl;
+    }
+}
+
+void Client::queueMessage(const SharedMessage& message) {
+    // 送信キューの上限を超えた接続には何も積まない（ブロードキャストで膨らみ続けないように）
+    if (_sendQExceeded) {
+        return;
+    }
+    pushOutput(message);
+    if (_server) {
+        _server->checkSendQ(this);
+    }
+}
+
+void Client::pushOutput(const SharedMessage& message) {
+    IoStats::instance().messagesOut++;
+
+    // io_uring使用時は送信をキューに積み、ループ末尾でまとめて投入
+    IoUring* ioUring = _server ? _server->getIoUring() : NULL;
+    if (ioUring) {
+        ioUring->queueSend(_fd, message.data(), message.length());
+        return;
+    }
+
+    // 送信キューに追加し、ループ末尾でまとめて書き出す
+    _sendQueue.push_back(message);
+    _sendQueueBytes += message.length();
+    accountMemory();
+    if (!_server) {
+        flushOutput();
+    } else if (!_flushScheduled) {
+        _flushScheduled = true;
+        _server->requestFlush(this);
+    }
+}
+
+// 送信キューを1回のwritevでまとめて書き出す（EAGAINで中断、エラー時はfalse）
+bool Client::flushOutput() {
+    while (!_sendQueue.empty() && _fd >= 0) {
+        struct iovec iov[MAX_WRITE_IOV];
+        int count = 0;
+        size_t batchBytes = 0;
+        for (std::deque<SharedMessage>::iterator it = _sendQueue.begin();
+             it != _sendQueue.end() && count < MAX_WRITE_IOV; ++it, ++count) {
+            size_t offset = (count == 0) ? _sendOffset : 0;
+            iov[count].iov_base = const_cast<char*>(it->data() + offset);
+            iov[count].iov_len = it->length() - offset;
+            batchBytes += iov[count].iov_len;
+        }
 
-        ssize_t sent = send(_fd, fullMessage.c_str(), fullMessage.length(), 0);
+        IoStats::instance().sendCalls++;
+        ssize_t sent = writev(_fd, iov, count);
         if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
             std::cerr << "\033[1;31m[ERROR] Error sending message to client: " << strerror(errno) << "\033[0m" << std::endl;
-        } else if (static_cast<size_t>(sent) != fullMessage.length()) {
-            std::cerr << "\033[1;33m[WARNING] Not all data was sent to client\033[0m" << std::endl;
+            _sendQueue.clear();
+            _sendOffset = 0;
+            _sendQueueBytes = 0;
+            markDisconnectPending();
+            accountMemory();
+            return false;
         }
-    } else {
-        std::cerr << "\033[1;31m[ERROR] Attempting to send message to invalid fd: " << _fd << "\033[0m" << std::endl;
+
+        // 送り切った行をキューから外す
+        IoStats::instance().writeBatches++;
+        _sendQueueBytes -= sent;
+        size_t remaining = sent;
+        while (remaining > 0) {
+            size_t lineLeft = _sendQueue.front().length() - _sendOffset;
+            if (remaining < lineLeft) {
+                _sendOffset += remaining;
+                break;
+            }
+            remaining -= lineLeft;
+            _sendQueue.pop_front();
+            _sendOffset = 0;
+            IoStats::instance().linesWritten++;
+        }
+        accountMemory();
+        // 書き込みきれなかった場合はソケットバッファが満杯
+        if ((size_t)sent < batchBytes) {
+            return true;
+        }
+    }
+    return true;
+}
+
+bool Client::hasQueuedOutput() const {
+    return !_sendQueue.empty();
+}
+
+size_t Client::getQueuedOutputSize() const {
+    // io_uring使用時は送信データをエンジン側で保持している
+    IoUring* ioUring = _server ? _server->getIoUring() : NULL;
+    if (ioUring) {
+        return ioUring->getQueuedBytes(_fd);
     }
+    return _sendQueueBytes;
+}
+
+ClientMemory Client::getMemoryUsage() const {
+    ClientMemory usage;
+    usage.object = sizeof(Client);
+    usage.recvPending = _recvEnd - _recvStart;
+    usage.sendQueue = getQueuedOutputSize();
+    usage.metadata = getHeapUsage();
+    return usage;
+}
+
+// スロット外のヒープ領域（送信キューの行本体はSharedMessageのプールで数える）
+size_t Client::getHeapUsage() const {
+    return _nickname.capacity() + _username.capacity() + _hostname.capacity()
+         + _realname.capacity() + _awayMessage.capacity() + _pingToken.capacity()
+         + _channels.capacity() * sizeof(NameId)
+         + _sendQueue.size() * sizeof(SharedMessage)
+         + _recvBacklog.capacity();
+}
+
+// 変更のあった構造のサイズを計り直し、差分だけ全体の集計に反映する
+void Client::accountMemory() {
+    size_t usage = getHeapUsage();
+    _heapTotal = _heapTotal - _heapAccounted + usage;
+    _heapAccounted = usage;
+}
+
+size_t Client::getHeapTotal() {
+    return _heapTotal;
+}
+
+// 切断で解放される分（Clientのスロットを除く）
+// 他のクライアントの送信キューも参照している行と、io_uringで送信中の分は残るため数えない
+size_t Client::getReleasableMemory() const {
+    size_t total = _heapAccounted;
+    IoUring* ioUring = _server ? _server->getIoUring() : NULL;
+    if (ioUring) {
+        return total + ioUring->getPendingBytes(_fd);
+    }
+    size_t slotSize = SharedMessage::getPoolStats().objectSize;
+    for (std::deque<SharedMessage>::const_iterator it = _sendQueue.begin(); it != _sendQueue.end(); ++it) {
+        if (!it->isShared()) {
+            total += slotSize;
+        }
+    }
+    return total;
+}
+
+bool Client::isSendQExceeded() const {
+    return _sendQExceeded;
+}
+
+time_t Client::getSendQAboveSince() const {
+    return _sendQAboveSince;
+}
+
+void Client::setSendQAboveSince(time_t since) {
+    _sendQAboveSince = since;
+    if (since == 0) {
+        _sendQTimer.cancel();
+    }
+}
+
+// キューが動かなくても停滞を判定できるよう、サーバーに再確認させる時刻を設定
+void Client::scheduleSendQCheck(unsigned long delayMs) {
+    _server->getTimers().schedule(_sendQTimer, std::max(delayMs, 1UL));
+}
+
+bool Client::isSendQCheckScheduled() const {
+    return _sendQTimer.isScheduled();
+}
+
+// 未送信の行を捨て、ERRORだけを送って切断を予約する
+void Client::exceedSendQ() {
+    if (_sendQExceeded) {
+        return;
+    }
+    std::cout << "\033[1;31m[SENDQ] Dropping " << getQueuedOutputSize() << " queued bytes for fd " << _fd
+              << ": SendQ exceeded\033[0m" << std::endl;
+
+    IoUring* ioUring = _server ? _server->getIoUring() : NULL;
+    if (ioUring) {
+        ioUring->discardPending(_fd);
+    } else if (!_sendQueue.empty()) {
+        // 送信途中の行は最後まで送る（行の途中でERRORが始まらないように）
+        size_t keep = (_sendOffset > 0) ? 1 : 0;
+        _sendQueue.erase(_sendQueue.begin() + keep, _sendQueue.end());
+        _sendQueueBytes = keep ? _sendQueue.front().length() - _sendOffset : 0;
+    }
+
+    pushOutput(SharedMessage("ERROR :SendQ exceeded"));
+    _sendQExceeded = true;
+    markDisconnectPending();
+}
+
+bool Client::isDisconnectPending() const {
+    return _disconnectPending;
+}
+
+// ERRORを送ってから切断を予約（削除はループ末尾で行う）
+void Client::disconnect(const std::string& reason) {
+    if (_disconnectPending) {
+        return;
+    }
+    std::cout << "\033[1;33m[CLIENT] Closing link for fd " << _fd << ": " << reason << "\033[0m" << std::endl;
+    sendMessage("ERROR :Closing Link: " + _hostname + " (" + reason + ")");
+    markDisconnectPending();
+}
+
+// 切断予定にし、サーバーの切断リストに一度だけ載せる
+void Client::markDisconnectPending() {
+    if (_disconnectPending) {
+        return;
+    }
+    _disconnectPending = true;
+    if (_server) {
+        _server->requestDisconnect(this);
+    }
+}
+
+void Client::setFlushScheduled(bool scheduled) {
+    _flushScheduled = scheduled;
 }
 
 void Client::sendNumericReply(int code, const std::string& message) {
@@ -403,4 +782,77 @@ bool Client::isRegistered() const {
 
 bool Client::hasCompletedRegistration() const {
     return _passAccepted && !_nickname.empty() && !_username.empty();
-}
\ No newline at end of file
+}
+
+void Client::onTimer(Timer& timer) {
+    // トークンが貯まったら保留中の行の処理をサーバーに依頼（コマンドはタイマー処理の外で実行する）
+    if (&timer == &_floodTimer) {
+        _server->scheduleHeldInput(this);
+        return;
+    }
+    if (&timer == &_sendQTimer) {
+        _server->checkSendQ(this);
+        return;
+    }
+
+    time_t now = time(NULL);
+
+    if (!isRegistered()) {
+        time_t deadline = _connectTime + REGISTRATION_TIMEOUT;
+        if (now >= deadline) {
+            disconnect("Registration timeout");
+            return;
+        }
+        _server->getTimers().schedule(timer, (deadline - now) * 1000UL);
+        return;
+    }
+
+    // PONG待ち: 期限までに応答（または何らかの受信）がなければ切断
+    if (!_pingToken.empty()) {
+        if (_lastActivity >= _pingSentAt) {
+            _pingToken.clear();
+        } else {
+            time_t deadline = _pingSentAt + _server->getPingTimeout();
+            if (now >= deadline) {
+                _server->recordPingTimeout();
+                disconnect("Ping timeout: " + Utils::toString(now - _pingSentAt) + " seconds");
+                return;
+            }
+            _server->getTimers().schedule(timer, (deadline - now) * 1000UL);
+            return;
+        }
+    }
+
+    // 活動のたびに再登録せず、満了時に最終活動時刻から期限を計算し直す
+    time_t deadline = _lastActivity + _server->getPingInterval();
+    if (now < deadline) {
+        _server->getTimers().schedule(timer, (deadline - now) * 1000UL);
+        return;
+    }
+
+    // 無通信が続いたのでPINGで生存確認
+    _pingSentAt = now;
+    _pingSentMs = TimerWheel::nowMs();
+    _pingToken = Utils::toString(_pingSentMs);
+    accountMemory();
+    sendMessage("PING :" + _pingToken);
+    _server->recordPingSent();
+    _server->getTimers().schedule(timer, _server->getPingTimeout() * 1000UL);
+}
+
+// サーバーからのPINGに対する応答を照合してRTTを記録
+bool Client::handlePong(const std::string& token) {
+    if (_pingToken.empty() || token != _pingToken) {
+        return false;
+    }
+    _lastRttMs = (long)(TimerWheel::nowMs() - _pingSentMs);
+    _pingToken.clear();
+    if (_server) {
+        _server->recordPingRtt(_lastRttMs);
+    }
+    return true;
+}
+
+long Client::getLastRtt() const {
+    return _lastRttMs;
+}
@@ -3,7 +3,7 @@
 #include "../include/DCCCommand.hpp"
 
 // コマンドベースクラス
-Command::Command(Server* server, Client* client, const std::string& name, const std::vector<std::string>& params)
+Command::Command(Server* server, Client* client, const std::string& name, const ParamList& params)
     : _server(server), _client(client), _name(name), _params(params), _requiresRegistration(true)
 {
 }
@@ -37,52 +37,207 @@ Server* Command::getServer() const {
     return _server;
 }
 
-std::vector<std::string> Command::getParams() const {
+const ParamList& Command::getParams() const {
     return _params;
 }
 
+// コマンドテーブル
+// 各コマンドはスタック上に生成して実行する（メッセージごとのnew/deleteなし）
+template <class T>
+static void runCommand(Server* server, Client* client, const ParamList& params) {
+    T command(server, client, params);
+    command.execute();
+}
+
+// 名前の先頭4バイトを詰めた値（4文字未満は0で埋める）
+# define PACK_NAME(a, b, c, d) (((unsigned)(unsigned char)(a) << 24) | ((unsigned)(unsigned char)(b) << 16) \
+                                | ((unsigned)(unsigned char)(c) << 8) | (unsigned)(unsigned char)(d))
+
+static unsigned packName(const char* name, size_t length) {
+    char bytes[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < length && i < 4; ++i) {
+        bytes[i] = name[i];
+    }
+    return PACK_NAME(bytes[0], bytes[1], bytes[2], bytes[3]);
+}
+
+// minParams: 不足時にERR_NEEDMOREPARAMSを返す
+// （不足時に独自の応答を返すコマンドや、再登録などの検査を先に行うコマンドは0にして各コマンドに任せる）
+// weight: フラッド制御の既定の重み（応答が多い・状態を変えるコマンドほど重い）
+static const CommandSpec COMMANDS[] = {
+    { "PASS",    runCommand<PassCommand>,    0, false, 1 },
+    { "NICK",    runCommand<NickCommand>,    0, false, 2 },
+    { "USER",    runCommand<UserCommand>,    0, false, 1 },
+    { "QUIT",    runCommand<QuitCommand>,    0, false, 1 },
+    { "JOIN",    runCommand<JoinCommand>,    1, true,  3 },
+    { "PART",    runCommand<PartCommand>,    1, true,  2 },
+    { "PRIVMSG", runCommand<PrivmsgCommand>, 0, true,  1 },
+    { "NOTICE",  runCommand<NoticeCommand>,  0, true,  1 },
+    { "KICK",    runCommand<KickCommand>,    2, true,  1 },
+    { "INVITE",  runCommand<InviteCommand>,  2, true,  2 },
+    { "TOPIC",   runCommand<TopicCommand>,   1, true,  1 },
+    { "MODE",    runCommand<ModeCommand>,    1, true,  2 },
+    { "PING",    runCommand<PingCommand>,    0, false, 1 },
+    { "PONG",    runCommand<PongCommand>,    0, false, 1 },
+    { "WHO",     runCommand<WhoCommand>,     0, true,  4 },
+    { "WHOIS",   runCommand<WhoisCommand>,   0, true,  2 },
+    { "CAP",     runCommand<CapCommand>,     0, false, 1 },
+    { "DCC",     NULL,                       0, true,  3 }     // サブコマンドで振り分け
+};
+
+static const size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+// DCCのサブコマンドはDCCの重みで計上する
+static const CommandSpec DCC_COMMANDS[] = {
+    { "SEND",    runCommand<DCCSendCommand>,   0, true,  0 },
+    { "GET",     runCommand<DCCGetCommand>,    0, true,  0 },
+    { "ACCEPT",  runCommand<DCCGetCommand>,    0, true,  0 },
+    { "REJECT",  runCommand<DCCRejectCommand>, 0, true,  0 },
+    { "LIST",    runCommand<DCCListCommand>,   0, true,  0 },
+    { "CANCEL",  runCommand<DCCCancelCommand>, 0, true,  0 },
+    { "STATUS",  runCommand<DCCStatusCommand>, 0, true,  0 }
+};
+
+// 先頭4バイトはどのコマンドも異なるため、switchで候補を1つに絞ってから全体を比較する
+static const CommandSpec* matchName(const CommandSpec* spec, const char* name, size_t length) {
+    if (strlen(spec->name) != length || memcmp(spec->name, name, length) != 0) {
+        return NULL;
+    }
+    return spec;
+}
+
+const CommandSpec* CommandFactory::findCommand(const char* name, size_t length) {
+    switch (packName(name, length)) {
+        case PACK_NAME('P', 'A', 'S', 'S'): return matchName(&COMMANDS[0], name, length);
+        case PACK_NAME('N', 'I', 'C', 'K'): return matchName(&COMMANDS[1], name, length);
+        case PACK_NAME('U', 'S', 'E', 'R'): return matchName(&COMMANDS[2], name, length);
+        case PACK_NAME('Q', 'U', 'I', 'T'): return matchName(&COMMANDS[3], name, length);
+        case PACK_NAME('J', 'O', 'I', 'N'): return matchName(&COMMANDS[4], name, length);
+        case PACK_NAME('P', 'A', 'R', 'T'): return matchName(&COMMANDS[5], name, length);
+        case PACK_NAME('P', 'R', 'I', 'V'): return matchName(&COMMANDS[6], name, length);
+        case PACK_NAME('N', 'O', 'T', 'I'): return matchName(&COMMANDS[7], name, length);
+        case PACK_NAME('K', 'I', 'C', 'K'): return matchName(&COMMANDS[8], name, length);
+        case PACK_NAME('I', 'N', 'V', 'I'): return matchName(&COMMANDS[9], name, length);
+        case PACK_NAME('T', 'O', 'P', 'I'): return matchName(&COMMANDS[10], name, length);
+        case PACK_NAME('M', 'O', 'D', 'E'): return matchName(&COMMANDS[11], name, length);
+        case PACK_NAME('P', 'I', 'N', 'G'): return matchName(&COMMANDS[12], name, length);
+        case PACK_NAME('P', 'O', 'N', 'G'): return matchName(&COMMANDS[13], name, length);
+        case PACK_NAME('W', 'H', 'O', 0):   return matchName(&COMMANDS[14], name, length);
+        case PACK_NAME('W', 'H', 'O', 'I'): return matchName(&COMMANDS[15], name, length);
+        case PACK_NAME('C', 'A', 'P', 0):   return matchName(&COMMANDS[16], name, length);
+        case PACK_NAME('D', 'C', 'C', 0):   return matchName(&COMMANDS[17], name, length);
+        default: return NULL;
+    }
+}
+
+const CommandSpec* CommandFactory::findDCCCommand(const char* name, size_t length) {
+    // サブコマンドは大文字小文字を区別する
+    switch (packName(name, length)) {
+        case PACK_NAME('S', 'E', 'N', 'D'): return matchName(&DCC_COMMANDS[0], name, length);
+        case PACK_NAME('G', 'E', 'T', 0):   return matchName(&DCC_COMMANDS[1], name, length);
+        case PACK_NAME('A', 'C', 'C', 'E'): return matchName(&DCC_COMMANDS[2], name, length);
+        case PACK_NAME('R', 'E', 'J', 'E'): return matchName(&DCC_COMMANDS[3], name, length);
+        case PACK_NAME('L', 'I', 'S', 'T'): return matchName(&DCC_COMMANDS[4], name, length);
+        case PACK_NAME('C', 'A', 'N', 'C'): return matchName(&DCC_COMMANDS[5], name, length);
+        case PACK_NAME('S', 'T', 'A', 'T'): return matchName(&DCC_COMMANDS[6], name, length);
+        default: return NULL;
+    }
+}
+
 // コマンドファクトリークラス
 CommandFactory::CommandFactory(Server* server) : _server(server) {
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        _weights.push_back(COMMANDS[i].weight);
+    }
+    // IRC_FLOOD_WEIGHTS="JOIN=5,WHO=8" の形式で既定の重みを上書き
+    const char* config = getenv("IRC_FLOOD_WEIGHTS");
+    if (config && *config) {
+        loadWeights(config);
+    }
+}
+
+void CommandFactory::loadWeights(const char* config) {
+    std::stringstream stream(config);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t equals = item.find('=');
+        std::string name = item.substr(0, equals);
+        for (size_t i = 0; i < name.length(); ++i) {
+            name[i] = toupper((unsigned char)name[i]);
+        }
+        const CommandSpec* spec = findCommand(name.c_str(), name.length());
+        char* end = NULL;
+        long weight = (equals == std::string::npos) ? -1 : strtol(item.c_str() + equals + 1, &end, 10);
+        if (!spec || weight < 0 || weight > 1000 || !end || *end != '\0') {
+            std::cout << "\033[1;31m[FLOOD] Ignoring invalid weight '" << item << "' in IRC_FLOOD_WEIGHTS\033[0m" << std::endl;
+            continue;
+        }
+        _weights[spec - COMMANDS] = (unsigned)weight;
+    }
+}
+
+unsigned CommandFactory::getCost(const char* message, size_t length) const {
+    // プレフィックスを飛ばしてコマンド名だけを取り出す
+    size_t pos = 0;
+    if (length > 0 && message[0] == ':') {
+        while (pos < length && message[pos] != ' ') {
+            pos++;
+        }
+        while (pos < length && message[pos] == ' ') {
+            pos++;
+        }
+    }
+    char name[MAX_COMMAND_LENGTH + 1];
+    size_t nameLength = 0;
+    while (pos < length && message[pos] != ' ') {
+        if (nameLength == MAX_COMMAND_LENGTH) {
+            return 1;
+        }
+        name[nameLength++] = toupper((unsigned char)message[pos++]);
+    }
+
+    const CommandSpec* spec = findCommand(name, nameLength);
+    return spec ? _weights[spec - COMMANDS] : 1;
+}
+
+std::string CommandFactory::describeWeights() const {
+    // 重みが1でないコマンドだけを並べる
+    std::string result;
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        if (_weights[i] != 1) {
+            result += (result.empty() ? "" : " ") + std::string(COMMANDS[i].name) + "=" + Utils::toString(_weights[i]);
+        }
+    }
+    return result.empty() ? "all 1" : result;
 }
 
 CommandFactory::~CommandFactory() {
     // 特に何もしない
 }
 
-Command* CommandFactory::createCommand(Client* client, const std::string& message) {
+bool CommandFactory::dispatch(Client* client, const char* message, size_t length) {
     // メッセージのサイズチェック
-    if (message.empty()) {
+    if (length == 0) {
         std::cout << "\033[1;31m[COMMAND] Empty message received\033[0m" << std::endl;
-        return NULL;
+        return false;
     }
 
-    if (message.length() > 512) {
+    if (length > 512) {
         std::cout << "\033[1;31m[COMMAND] Message too long, truncating to 512 characters\033[0m" << std::endl;
         // メッセージが長すぎる場合は無視（RFC準拠）
-        return NULL;
+        return false;
     }
 
-    Parser parser(message);
+    // 行をコピーせずにパースし、コマンドには行への参照を渡す
+    Parser parser(message, length);
     if (!parser.isValid()) {
         std::cout << "\033[1;31m[PARSER] Invalid message format: " << message << "\033[0m" << std::endl;
-        return NULL;
-    }
-
-    std::string command = parser.getCommand();
-    std::vector<std::string> params = parser.getParams();
-
-    // 不正なコマンド名のチェック
-    if (command.empty() || command.length() > 16) {
-        std::cout << "\033[1;31m[COMMAND] Invalid command name: '" << command << "'\033[0m" << std::endl;
-        return NULL;
+        return false;
     }
 
-    // 過剰なパラメータ数のチェック
-    if (params.size() > 15) {
-        std::cout << "\033[1;31m[COMMAND] Too many parameters: " << params.size() << " (max 15)\033[0m" << std::endl;
-        // RFC 2812によれば、最大15パラメータまで
-        params.resize(15);
-    }
+    // コマンド名の長さとパラメータ数（最大15）はParserで検証済み
+    const char* command = parser.getCommandName();
+    ParamList params = parser.getParams();
 
     std::cout << "\033[1;36m[COMMAND] Creating command: " << command;
     if (!params.empty()) {
@@ -96,79 +251,52 @@ Command* CommandFactory::createCommand(Client* client, const std::string& messag
     }
     std::cout << "\033[0m" << std::endl;
 
-    // 使用可能なコマンドを作成
-    if (command == "PASS") {
-        return new PassCommand(_server, client, params);
-    } else if (command == "NICK") {
-        return new NickCommand(_server, client, params);
-    } else if (command == "USER") {
-        return new UserCommand(_server, client, params);
-    } else if (command == "QUIT") {
-        return new QuitCommand(_server, client, params);
-    } else if (command == "JOIN") {
-        return new JoinCommand(_server, client, params);
-    } else if (command == "PART") {
-        return new PartCommand(_server, client, params);
-    } else if (command == "PRIVMSG") {
-        return new PrivmsgCommand(_server, client, params);
-    } else if (command == "NOTICE") {
-        return new NoticeCommand(_server, client, params);
-    } else if (command == "KICK") {
-        return new KickCommand(_server, client, params);
-    } else if (command == "INVITE") {
-        return new InviteCommand(_server, client, params);
-    } else if (command == "TOPIC") {
-        return new TopicCommand(_server, client, params);
-    } else if (command == "MODE") {
-        return new ModeCommand(_server, client, params);
-    } else if (command == "PING") {
-        return new PingCommand(_server, client, params);
-    } else if (command == "PONG") {
-        return new PongCommand(_server, client, params);
-    } else if (command == "WHO") {
-        return new WhoCommand(_server, client, params);
-    } else if (command == "WHOIS") {
-        return new WhoisCommand(_server, client, params);
-    } else if (command == "CAP") {
-        return new CapCommand(_server, client, params);
-    } else if (command == "DCC") {
+    const CommandSpec* spec = findCommand(command, strlen(command));
+    if (!spec) {
+        // 未知のコマンド
+        std::cout << "\033[1;31m[COMMAND] Unknown command: " << command << "\033[0m" << std::endl;
+
+        // クライアントがすでに登録されている場合のみエラーを送信
+        if (client->isRegistered()) {
+            client->sendNumericReply(421, std::string(command) + " :Unknown command");
+        }
+        return false;
+    }
+
+    if (!spec->run) {
         // DCCサブコマンドの処理
         if (params.empty()) {
             client->sendMessage(":server NOTICE " + client->getNickname() + 
                               " :Usage: DCC <SEND|GET|ACCEPT|REJECT|LIST|CANCEL|STATUS> ...\r\n");
-            return NULL;
+            return false;
         }
-        
-        std::string subCommand = params[0];
-        // パラメータからサブコマンドを削除
-        std::vector<std::string> dccParams(params.begin() + 1, params.end());
-        
-        if (subCommand == "SEND") {
-            return new DCCSendCommand(_server, client, dccParams);
-        } else if (subCommand == "GET" || subCommand == "ACCEPT") {
-            return new DCCGetCommand(_server, client, dccParams);
-        } else if (subCommand == "REJECT") {
-            return new DCCRejectCommand(_server, client, dccParams);
-        } else if (subCommand == "LIST") {
-            return new DCCListCommand(_server, client, dccParams);
-        } else if (subCommand == "CANCEL") {
-            return new DCCCancelCommand(_server, client, dccParams);
-        } else if (subCommand == "STATUS") {
-            return new DCCStatusCommand(_server, client, dccParams);
-        } else {
+
+        const CommandSpec* subSpec = findDCCCommand(params.data(0), params.length(0));
+        if (!subSpec) {
             client->sendMessage(":server NOTICE " + client->getNickname() + 
-                              " :Unknown DCC subcommand: " + subCommand + "\r\n");
-            return NULL;
+                              " :Unknown DCC subcommand: " + params[0] + "\r\n");
+            return false;
         }
+        // パラメータからサブコマンドを削除
+        return run(*subSpec, client, params.shift(1));
     }
 
-    // 未知のコマンド
-    std::cout << "\033[1;31m[COMMAND] Unknown command: " << command << "\033[0m" << std::endl;
+    return run(*spec, client, params);
+}
 
-    // クライアントがすでに登録されている場合のみエラーを送信
-    if (client->isRegistered()) {
-        client->sendNumericReply(421, command + " :Unknown command");
+bool CommandFactory::run(const CommandSpec& spec, Client* client, const ParamList& params) {
+    // テーブルの情報で共通の事前チェックを行う
+    if (spec.requiresRegistration && !client->isRegistered()) {
+        client->sendNumericReply(ERR_NOTREGISTERED, ":You have not registered");
+        std::cout << "\033[1;31m[COMMAND] " << spec.name << " failed: client not registered\033[0m" << std::endl;
+        return false;
     }
-
-    return NULL;
+    if (params.size() < spec.minParams) {
+        client->sendNumericReply(ERR_NEEDMOREPARAMS, std::string(spec.name) + " :Not enough parameters");
+        return false;
     }
+
+    std::cout << "\033[1;36m[COMMAND] Executing command: " << spec.name << "\033[0m" << std::endl;
+    spec.run(_server, client, params);
+    return true;
+}
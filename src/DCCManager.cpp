@@ -8,14 +8,14 @@
 #include <arpa/inet.h>
 
 DCCManager::DCCManager(Server* server) 
-    : _server(server), _nextPort(MIN_DCC_PORT) {
+    : _server(server), _transferPool("dcc"), _nextPort(MIN_DCC_PORT) {
 }
 
 DCCManager::~DCCManager() {
     // すべての転送をクリーンアップ
     for (std::map<std::string, DCCTransfer*>::iterator it = _transfers.begin(); 
          it != _transfers.end(); ++it) {
-        delete it->second;
+        _transferPool.destroy(it->second);
     }
     _transfers.clear();
     _socketTransfers.clear();
@@ -39,11 +39,11 @@ std::string DCCManager::createSendTransfer(Client* sender, Client* receiver,
     }
     
     // 新しい転送を作成
-    DCCTransfer* transfer = new DCCTransfer(sender, receiver, filename, filesize, DCC_SEND);
+    DCCTransfer* transfer = new (_transferPool.allocate()) DCCTransfer(sender, receiver, filename, filesize, DCC_SEND);
     
     // 送信の初期化
     if (!transfer->initializeSend()) {
-        delete transfer;
+        _transferPool.destroy(transfer);
         return "";
     }
     
@@ -77,7 +77,7 @@ bool DCCManager::acceptTransfer(Client* client, const std::string& transferId) {
     int senderPort = senderTransfer->getPort();
     
     // 受信側用の新しいDCC転送オブジェクトを作成
-    DCCTransfer* receiverTransfer = new DCCTransfer(
+    DCCTransfer* receiverTransfer = new (_transferPool.allocate()) DCCTransfer(
         senderTransfer->getSender(), 
         client, 
         senderTransfer->getFilename(), 
@@ -90,7 +90,7 @@ bool DCCManager::acceptTransfer(Client* client, const std::string& transferId) {
     
     // 受信側の接続を初期化
     if (!receiverTransfer->initializeReceive(senderIP, senderPort)) {
-        delete receiverTransfer;
+        _transferPool.destroy(receiverTransfer);
         return false;
     }
     
@@ -155,9 +155,14 @@ void DCCManager::processTransfers() {
     
     for (size_t i = 0; i < activeTransfers.size(); ++i) {
         DCCTransfer* transfer = activeTransfers[i];
+        int oldListenSocket = transfer->getListenSocket();
+        int oldDataSocket = transfer->getDataSocket();
         
         // 転送を処理
-        if (transfer->processTransfer()) {
+        bool processed = transfer->processTransfer();
+        refreshTransferSockets(transfer, oldListenSocket, oldDataSocket);
+        
+        if (processed) {
             // 進捗を通知（10%ごと）
             static std::map<std::string, int> lastProgress;
             int currentProgress = (int)(transfer->getProgress() / 10) * 10;
@@ -177,18 +182,20 @@ void DCCManager::processTransfers() {
             cleanupTransfer(transfer);
         }
     }
-    
-    // タイムアウトチェック
-    checkTimeouts();
 }
 
 void DCCManager::handleTransferSocket(int socket) {
     DCCTransfer* transfer = getTransferBySocket(socket);
     if (!transfer) {
+        // 対応する転送がないソケットは監視を解除
+        removeTransferSocket(socket);
         return;
     }
     
+    int oldListenSocket = transfer->getListenSocket();
+    int oldDataSocket = transfer->getDataSocket();
     transfer->processTransfer();
+    refreshTransferSockets(transfer, oldListenSocket, oldDataSocket);
     
     if (transfer->isCompleted()) {
         notifyTransferComplete(transfer);
@@ -199,24 +206,23 @@ void DCCManager::handleTransferSocket(int socket) {
     }
 }
 
-void DCCManager::checkTimeouts() {
-    std::vector<std::string> timedOutTransfers;
-    
-    for (std::map<std::string, DCCTransfer*>::iterator it = _transfers.begin();
-         it != _transfers.end(); ++it) {
-        if (it->second->isTimeout()) {
-            timedOutTransfers.push_back(it->first);
-        }
+void DCCManager::onTimer(Timer& timer) {
+    // 転送ごとのタイマー満了時に無通信時間を確認（活動があれば残り時間で再登録）
+    DCCTransfer* transfer = static_cast<DCCTransfer*>(timer.getContext());
+    if (transfer->isCompleted() || transfer->getStatus() == DCC_FAILED || transfer->getStatus() == DCC_REJECTED) {
+        return;
     }
-    
-    for (size_t i = 0; i < timedOutTransfers.size(); ++i) {
-        DCCTransfer* transfer = getTransfer(timedOutTransfers[i]);
-        if (transfer) {
-            transfer->setStatus(DCC_FAILED);
-            notifyTransferFailed(transfer);
-            cleanupTransfer(transfer);
-        }
+
+    time_t deadline = transfer->getLastActivity() + TRANSFER_TIMEOUT;
+    time_t now = time(NULL);
+    if (now < deadline) {
+        _server->getTimers().schedule(timer, (deadline - now) * 1000UL);
+        return;
     }
+
+    transfer->setStatus(DCC_FAILED);
+    notifyTransferFailed(transfer);
+    cleanupTransfer(transfer);
 }
 
 DCCTransfer* DCCManager::getTransfer(const std::string& transferId) {
@@ -374,10 +380,31 @@ bool DCCManager::checkAndAutoAcceptGetRequest(Client* sender, Client* receiver,
 
 void DCCManager::addTransferSocket(int socket, DCCTransfer* transfer) {
     _socketTransfers[socket] = transfer;
+    _server->watchDCCSocket(socket, transfer);
 }
 
 void DCCManager::removeTransferSocket(int socket) {
     _socketTransfers.erase(socket);
+    _server->unwatchFd(socket);
+}
+
+void DCCManager::refreshTransferSockets(DCCTransfer* transfer, int oldListenSocket, int oldDataSocket) {
+    // acceptConnection()でリスニングソケットが閉じられ、データソケットが作られた場合に登録を更新
+    if (oldListenSocket >= 0 && transfer->getListenSocket() != oldListenSocket) {
+        removeTransferSocket(oldListenSocket);
+    }
+    if (transfer->getDataSocket() >= 0 && transfer->getDataSocket() != oldDataSocket) {
+        addTransferSocket(transfer->getDataSocket(), transfer);
+    }
+}
+
+void DCCManager::unregisterTransferSockets(DCCTransfer* transfer) {
+    if (transfer->getListenSocket() >= 0) {
+        removeTransferSocket(transfer->getListenSocket());
+    }
+    if (transfer->getDataSocket() >= 0) {
+        removeTransferSocket(transfer->getDataSocket());
+    }
 }
 
 std::vector<int> DCCManager::getTransferSockets() {
@@ -455,6 +482,10 @@ unsigned long DCCManager::getTotalBytesTransferred() const {
     return total;
 }
 
+const PoolStats& DCCManager::getPoolStats() const {
+    return _transferPool.getStats();
+}
+
 void DCCManager::notifySendRequest(DCCTransfer* transfer) {
     if (!transfer) return;
     
@@ -627,6 +658,10 @@ void DCCManager::addTransfer(DCCTransfer* transfer) {
     if (!transfer) return;
     
     _transfers[transfer->getId()] = transfer;
+
+    // タイムアウトを登録（転送の破棄時に自動で解除される）
+    transfer->getTimeoutTimer().setHandler(this, transfer);
+    _server->getTimers().schedule(transfer->getTimeoutTimer(), TRANSFER_TIMEOUT * 1000UL);
     
     // ソケットマッピングを追加
     if (transfer->getListenSocket() >= 0) {
@@ -647,12 +682,7 @@ void DCCManager::removeTransfer(const std::string& transferId) {
     DCCTransfer* transfer = it->second;
     
     // ソケットマッピングを削除
-    if (transfer->getListenSocket() >= 0) {
-        removeTransferSocket(transfer->getListenSocket());
-    }
-    if (transfer->getDataSocket() >= 0) {
-        removeTransferSocket(transfer->getDataSocket());
-    }
+    unregisterTransferSockets(transfer);
     
     // ペンディング転送リストから削除
     if (transfer->getReceiver()) {
@@ -661,13 +691,15 @@ void DCCManager::removeTransfer(const std::string& transferId) {
     }
     
     // 転送を削除
-    delete transfer;
+    _transferPool.destroy(transfer);
     _transfers.erase(it);
 }
 
 void DCCManager::cleanupTransfer(DCCTransfer* transfer) {
     if (!transfer) return;
     
+    // ソケットを閉じる前に監視対象から外す
+    unregisterTransferSockets(transfer);
     transfer->cleanup();
     removeTransfer(transfer->getId());
 }
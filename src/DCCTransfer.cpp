@@ -13,13 +13,12 @@ DCCTransfer::DCCTransfer(Client* sender, Client* receiver, const std::string& fi
                          unsigned long filesize, DCCTransferType type)
     : _sender(sender), _receiver(receiver), _filename(filename), _filesize(filesize),
       _bytesTransferred(0), _type(type), _status(DCC_PENDING), _listenSocket(-1),
-      _dataSocket(-1), _port(0), _sendFile(NULL), _recvFile(NULL), _buffer(NULL),
+      _dataSocket(-1), _port(0),
       _lastFlushBytes(0) {
     
     _id = generateTransferId();
     _startTime = time(NULL);
     _lastActivity = _startTime;
-    _buffer = new char[DCC_BUFFER_SIZE];
     
     // ファイルパスの設定
     if (_type == DCC_SEND) {
@@ -33,10 +32,6 @@ DCCTransfer::DCCTransfer(Client* sender, Client* receiver, const std::string& fi
 
 DCCTransfer::~DCCTransfer() {
     cleanup();
-    if (_buffer) {
-        delete[] _buffer;
-        _buffer = NULL;
-    }
 }
 
 bool DCCTransfer::initializeSend() {
@@ -156,19 +151,19 @@ bool DCCTransfer::acceptConnection() {
 }
 
 bool DCCTransfer::sendData() {
-    if (_status != DCC_ACTIVE || !_sendFile || _dataSocket < 0) {
-        std::cout << "[DCC] sendData: Invalid state (status=" << _status << ", sendFile=" << (_sendFile ? "OK" : "NULL") << ", dataSocket=" << _dataSocket << ")" << std::endl;
+    if (_status != DCC_ACTIVE || !_sendFile.is_open() || _dataSocket < 0) {
+        std::cout << "[DCC] sendData: Invalid state (status=" << _status << ", sendFile=" << (_sendFile.is_open() ? "OK" : "NULL") << ", dataSocket=" << _dataSocket << ")" << std::endl;
         return false;
     }
     
-    if (_sendFile->eof() || _bytesTransferred >= _filesize) {
+    if (_sendFile.eof() || _bytesTransferred >= _filesize) {
         std::cout << "[DCC] Transfer complete: " << _bytesTransferred << "/" << _filesize << " bytes" << std::endl;
         _status = DCC_COMPLETED;
         return true;
     }
     
-    _sendFile->read(_buffer, DCC_BUFFER_SIZE);
-    std::streamsize bytesRead = _sendFile->gcount();
+    _sendFile.read(_buffer, DCC_BUFFER_SIZE);
+    std::streamsize bytesRead = _sendFile.gcount();
     
     if (bytesRead > 0) {
         ssize_t bytesSent = send(_dataSocket, _buffer, bytesRead, MSG_NOSIGNAL);
@@ -193,7 +188,7 @@ bool DCCTransfer::sendData() {
 }
 
 bool DCCTransfer::receiveData() {
-    if (_status != DCC_ACTIVE || !_recvFile || _dataSocket < 0) {
+    if (_status != DCC_ACTIVE || !_recvFile.is_open() || _dataSocket < 0) {
         return false;
     }
     
@@ -205,18 +200,18 @@ bool DCCTransfer::receiveData() {
     ssize_t bytesReceived = recv(_dataSocket, _buffer, DCC_BUFFER_SIZE, 0);
     
     if (bytesReceived > 0) {
-        _recvFile->write(_buffer, bytesReceived);
+        _recvFile.write(_buffer, bytesReceived);
         _bytesTransferred += bytesReceived;
         updateLastActivity();
         
         // 定期的なフラッシュ（64KB毎）または毎回フラッシュ
         if ((_bytesTransferred - _lastFlushBytes) >= DCC_FLUSH_INTERVAL || 
             _bytesTransferred % 32768 == 0) { // 32KB毎にもフラッシュ
-            _recvFile->flush();
+            _recvFile.flush();
             _lastFlushBytes = _bytesTransferred;
         } else {
             // 小さなチャンクでも毎回フラッシュ（Linux環境での信頼性向上）
-            _recvFile->flush();
+            _recvFile.flush();
         }
         
         // 受信確認の送信（DCC プロトコル）
@@ -226,7 +221,7 @@ bool DCCTransfer::receiveData() {
         if (_bytesTransferred >= _filesize) {
             _status = DCC_COMPLETED;
             // 転送完了時には確実にバッファをフラッシュ
-            _recvFile->flush();
+            _recvFile.flush();
         }
         return true;
     } else if (bytesReceived == 0) {
@@ -237,8 +232,8 @@ bool DCCTransfer::receiveData() {
             _status = DCC_FAILED;
         }
         // 接続終了時にもバッファをフラッシュ
-        if (_recvFile) {
-            _recvFile->flush();
+        if (_recvFile.is_open()) {
+            _recvFile.flush();
         }
         return false;
     } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -281,6 +276,14 @@ bool DCCTransfer::isTimeout() const {
     return (time(NULL) - _lastActivity) > 300; // 5分のタイムアウト
 }
 
+time_t DCCTransfer::getLastActivity() const {
+    return _lastActivity;
+}
+
+Timer& DCCTransfer::getTimeoutTimer() {
+    return _timeoutTimer;
+}
+
 bool DCCTransfer::isCompleted() const {
     return _status == DCC_COMPLETED;
 }
@@ -408,43 +411,31 @@ std::string DCCTransfer::getLocalIP() const {
 }
 
 bool DCCTransfer::openSendFile() {
-    _sendFile = new std::ifstream(_filepath.c_str(), std::ios::binary);
-    if (!_sendFile->is_open()) {
-        delete _sendFile;
-        _sendFile = NULL;
-        return false;
-    }
-    return true;
+    _sendFile.clear();
+    _sendFile.open(_filepath.c_str(), std::ios::binary);
+    return _sendFile.is_open();
 }
 
 bool DCCTransfer::openReceiveFile() {
     // 転送ディレクトリの作成
     system("mkdir -p ./dcc_transfers/received/");
     
-    _recvFile = new std::ofstream(_filepath.c_str(), std::ios::binary);
-    if (!_recvFile->is_open()) {
-        delete _recvFile;
-        _recvFile = NULL;
-        return false;
-    }
-    return true;
+    _recvFile.clear();
+    _recvFile.open(_filepath.c_str(), std::ios::binary);
+    return _recvFile.is_open();
 }
 
 void DCCTransfer::closeSendFile() {
-    if (_sendFile) {
-        _sendFile->close();
-        delete _sendFile;
-        _sendFile = NULL;
+    if (_sendFile.is_open()) {
+        _sendFile.close();
     }
 }
 
 void DCCTransfer::closeReceiveFile() {
-    if (_recvFile) {
+    if (_recvFile.is_open()) {
         // ファイルクローズ前に確実にバッファをフラッシュ
-        _recvFile->flush();
-        _recvFile->close();
-        delete _recvFile;
-        _recvFile = NULL;
+        _recvFile.flush();
+        _recvFile.close();
     }
 }
 
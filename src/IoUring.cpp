@@ -0,0 +1,720 @@
+#include "../include/IoUring.hpp"
+#include "../include/Reactor.hpp"
+
+#if defined(USE_IO_URING) && defined(__linux__)
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <cstddef>
+
+// user_data: 上位32bitに世代、8bit目以降にfd、下位8bitに操作種別
+enum UringOp {
+    OP_RECV = 1,
+    OP_SEND = 2,
+    OP_POLL = 3,
+    OP_CANCEL = 4,
+    OP_TIMEOUT = 5
+};
+
+static unsigned long long makeUserData(int fd, unsigned generation, UringOp op) {
+    return ((unsigned long long)generation << 32) | ((unsigned long long)(fd & 0xffffff) << 8) | op;
+}
+
+IoUring::IoUring()
+    : _ringFd(-1), _sqEntries(0), _sqRing(MAP_FAILED), _cqRing(MAP_FAILED),
+      _sqRingSize(0), _cqRingSize(0), _sqes((struct io_uring_sqe*)MAP_FAILED), _sqesSize(0),
+      _sqHead(NULL), _sqTail(NULL), _sqMask(NULL), _sqArray(NULL),
+      _cqHead(NULL), _cqTail(NULL), _cqMask(NULL), _cqes(NULL), _sqLocalTail(0),
+      _bufRing(MAP_FAILED), _bufRingSize(0), _bufPool(NULL), _bufTail(0),
+      _reactorFd(-1), _reactorQueued(false), _queuedBytes(0) {
+}
+
+IoUring::~IoUring() {
+    // リングを閉じると実行中の操作はカーネル側で取り消される
+    if (_ringFd >= 0) {
+        close(_ringFd);
+    }
+    for (std::map<unsigned long long, OrphanSend>::iterator it = _orphanSends.begin(); it != _orphanSends.end(); ++it) {
+        if (it->second.fd >= 0) {
+            close(it->second.fd);
+        }
+    }
+    if (_sqes != MAP_FAILED) {
+        munmap(_sqes, _sqesSize);
+    }
+    if (_cqRing != MAP_FAILED && _cqRing != _sqRing) {
+        munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing != MAP_FAILED) {
+        munmap(_sqRing, _sqRingSize);
+    }
+    if (_bufRing != MAP_FAILED) {
+        munmap(_bufRing, _bufRingSize);
+    }
+    delete[] _bufPool;
+}
+
+bool IoUring::isAvailable() {
+    return true;
+}
+
+bool IoUring::init(int reactorFd) {
+    if (!setupRings() || !setupBufferRing()) {
+        return false;
+    }
+    _reactorFd = reactorFd;
+    armReactorPoll();
+    std::cout << "\033[1;36m[IO_URING] Ring ready (" << _sqEntries << " entries, "
+              << BUFFER_COUNT << " x " << BUFFER_BYTES << " byte receive buffers)\033[0m" << std::endl;
+    return true;
+}
+
+bool IoUring::setupRings() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    _ringFd = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (_ringFd < 0 && errno == EINVAL) {
+        // 古いカーネルではセットアップフラグなしで再試行
+        memset(&params, 0, sizeof(params));
+        _ringFd = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    }
+    if (_ringFd < 0) {
+        std::cout << "\033[1;33m[IO_URING] io_uring_setup() failed: " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+    // 待機タイムアウトの指定にEXT_ARGが必要
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        std::cout << "\033[1;33m[IO_URING] Kernel lacks IORING_FEAT_EXT_ARG\033[0m" << std::endl;
+        return false;
+    }
+    _sqEntries = params.sq_entries;
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+    }
+
+    _sqRing = mmap(NULL, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED) {
+        std::cout << "\033[1;33m[IO_URING] mmap(SQ ring) failed: " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+    if (singleMmap) {
+        _cqRing = _sqRing;
+    } else {
+        _cqRing = mmap(NULL, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+        if (_cqRing == MAP_FAILED) {
+            std::cout << "\033[1;33m[IO_URING] mmap(CQ ring) failed: " << strerror(errno) << "\033[0m" << std::endl;
+            return false;
+        }
+    }
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = (struct io_uring_sqe*)mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+    if (_sqes == MAP_FAILED) {
+        std::cout << "\033[1;33m[IO_URING] mmap(SQEs) failed: " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+
+    char* sq = (char*)_sqRing;
+    char* cq = (char*)_cqRing;
+    _sqHead = (unsigned*)(sq + params.sq_off.head);
+    _sqTail = (unsigned*)(sq + params.sq_off.tail);
+    _sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    _sqArray = (unsigned*)(sq + params.sq_off.array);
+    _cqHead = (unsigned*)(cq + params.cq_off.head);
+    _cqTail = (unsigned*)(cq + params.cq_off.tail);
+    _cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    _cqes = cq + params.cq_off.cqes;
+    _sqLocalTail = *_sqTail;
+    return true;
+}
+
+bool IoUring::setupBufferRing() {
+    // struct io_uring_buf_ring はC++ではレイアウトが変わるため、
+    // struct io_uring_buf の配列として扱う（先頭要素のresvが末尾インデックス）
+    _bufRingSize = BUFFER_COUNT * sizeof(struct io_uring_buf);
+    _bufRing = mmap(NULL, _bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (_bufRing == MAP_FAILED) {
+        std::cout << "\033[1;33m[IO_URING] mmap(buffer ring) failed: " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+    memset(_bufRing, 0, _bufRingSize);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)_bufRing;
+    reg.ring_entries = BUFFER_COUNT;
+    reg.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, _ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        std::cout << "\033[1;33m[IO_URING] Provided buffer ring not supported: " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+
+    _bufPool = new char[BUFFER_COUNT * BUFFER_BYTES];
+    for (unsigned i = 0; i < BUFFER_COUNT; ++i) {
+        addBuffer(i);
+    }
+    return true;
+}
+
+void IoUring::addBuffer(int bufferId) {
+    struct io_uring_buf* bufs = (struct io_uring_buf*)_bufRing;
+    struct io_uring_buf* buf = &bufs[_bufTail & (BUFFER_COUNT - 1)];
+    buf->addr = (unsigned long)(_bufPool + bufferId * BUFFER_BYTES);
+    buf->len = BUFFER_BYTES;
+    buf->bid = bufferId;
+    _bufTail++;
+    unsigned short* tail = (unsigned short*)((char*)_bufRing + offsetof(struct io_uring_buf, resv));
+    __atomic_store_n(tail, _bufTail, __ATOMIC_RELEASE);
+}
+
+struct io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    if (_sqLocalTail - head >= _sqEntries) {
+        // SQが満杯の場合は溜まっている分を先に投入
+        enter(0, -1);
+        head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+        if (_sqLocalTail - head >= _sqEntries) {
+            return NULL;
+        }
+    }
+    unsigned index = _sqLocalTail & *_sqMask;
+    struct io_uring_sqe* sqe = &_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    _sqArray[index] = index;
+    _sqLocalTail++;
+    return sqe;
+}
+
+int IoUring::enter(unsigned minComplete, int timeoutMs) {
+    __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = _sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+
+    unsigned flags = 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    void* argp = NULL;
+    size_t argSize = 0;
+    if (minComplete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeoutMs >= 0) {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = (unsigned long)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            argp = &arg;
+            argSize = sizeof(arg);
+        }
+    }
+    if (toSubmit == 0 && flags == 0) {
+        return 0;
+    }
+
+    IoStats::instance().waitCalls++;
+    return syscall(__NR_io_uring_enter, _ringFd, toSubmit, minComplete, flags, argp, argSize);
+}
+
+IoUring::Connection& IoUring::connection(int fd) {
+    if ((size_t)fd >= _conns.size()) {
+        Connection empty;
+        empty.attached = false;
+        empty.generation = 0;
+        empty.sending = false;
+        empty.pendingLines = 0;
+        empty.inflightLines = 0;
+        empty.recvArmed = false;
+        empty.recvPaused = false;
+        _conns.resize(fd + 1, empty);
+    }
+    return _conns[fd];
+}
+
+void IoUring::armRecv(int fd) {
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = makeUserData(fd, _conns[fd].generation, OP_RECV);
+    _conns[fd].recvArmed = true;
+}
+
+void IoUring::armReactorPoll() {
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = _reactorFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = makeUserData(_reactorFd, 0, OP_POLL);
+}
+
+void IoUring::submitSend(int fd) {
+    Connection& conn = _conns[fd];
+    if (conn.sending) {
+        return;
+    }
+    if (conn.inflight.empty()) {
+        if (conn.pending.empty()) {
+            return;
+        }
+        conn.inflight.swap(conn.pending);
+        conn.inflightLines = conn.pendingLines;
+        conn.pendingLines = 0;
+    }
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        _sendReady.push_back(fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)conn.inflight.data();
+    sqe->len = conn.inflight.size();
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = makeUserData(fd, conn.generation, OP_SEND);
+    conn.sending = true;
+    IoStats::instance().writeBatches++;
+}
+
+void IoUring::attach(int fd) {
+    Connection& conn = connection(fd);
+    conn.attached = true;
+    conn.generation++;
+    conn.sending = false;
+    conn.pending.clear();
+    conn.inflight.clear();
+    conn.pendingLines = 0;
+    conn.inflightLines = 0;
+    conn.recvArmed = false;
+    conn.recvPaused = false;
+    armRecv(fd);
+}
+
+void IoUring::detach(int fd) {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached) {
+        return;
+    }
+    Connection& conn = _conns[fd];
+
+    if (conn.sending) {
+        // 実行中の送信データはカーネルが参照しているため完了まで保持し、未投入の分（QUITの応答や
+        // ERRORなど）はその完了後に続けて送る（集計からは送信完了時に外す）
+        OrphanSend& orphan = _orphanSends[makeUserData(fd, conn.generation, OP_SEND)];
+        orphan.fd = dup(fd);
+        orphan.inflight.swap(conn.inflight);
+        if (orphan.fd >= 0) {
+            orphan.pending.swap(conn.pending);
+        }
+
+        // recvだけを取り消し、送信には期限を付ける（読まない相手でfdが残り続けないように）
+        struct io_uring_sqe* sqe = getSqe();
+        if (sqe && conn.recvArmed) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = makeUserData(fd, conn.generation, OP_RECV);
+            sqe->user_data = makeUserData(fd, conn.generation, OP_CANCEL);
+            sqe = getSqe();
+        }
+        struct __kernel_timespec ts;
+        ts.tv_sec = ORPHAN_TIMEOUT_SECONDS;
+        ts.tv_nsec = 0;
+        if (sqe) {
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->fd = -1;
+            sqe->addr = (unsigned long)&ts;
+            sqe->len = 1;
+            sqe->user_data = makeUserData(fd, conn.generation, OP_TIMEOUT);
+        }
+        _queuedBytes -= conn.pending.size();
+        conn.attached = false;
+        conn.sending = false;
+        conn.recvArmed = false;
+        conn.pending.clear();
+        enter(0, -1);
+        return;
+    }
+
+    // 未投入の送信データは切断前に直接送信を試みる（QUITの応答など）
+    if (!conn.pending.empty()) {
+        IoStats::instance().sendCalls++;
+        send(fd, conn.pending.data(), conn.pending.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    _queuedBytes -= conn.pending.size() + conn.inflight.size();
+    conn.attached = false;
+    conn.recvArmed = false;
+    conn.pending.clear();
+    conn.inflight.clear();
+
+    // fdに紐づく操作を取り消し、close()前に投入する
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = makeUserData(fd, conn.generation, OP_CANCEL);
+    }
+    enter(0, -1);
+}
+
+void IoUring::submitOrphanSend(unsigned long long key, OrphanSend& orphan) {
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        closeOrphan(_orphanSends.find(key));
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = orphan.fd;
+    sqe->addr = (unsigned long)orphan.inflight.data();
+    sqe->len = orphan.inflight.size();
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = key;
+    IoStats::instance().writeBatches++;
+}
+
+// 切断後の送信を終え、dup()したfdを閉じる（期限のタイマーも取り消す）
+void IoUring::closeOrphan(std::map<unsigned long long, OrphanSend>::iterator orphan) {
+    _queuedBytes -= orphan->second.inflight.size() + orphan->second.pending.size();
+    if (orphan->second.fd >= 0) {
+        close(orphan->second.fd);
+    }
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe) {
+        sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = (orphan->first & ~0xffULL) | OP_TIMEOUT;
+        sqe->user_data = (orphan->first & ~0xffULL) | OP_CANCEL;
+    }
+    _orphanSends.erase(orphan);
+}
+
+void IoUring::queueSend(int fd, const char* data, size_t length) {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached) {
+        return;
+    }
+    Connection& conn = _conns[fd];
+    if (conn.pending.empty() && !conn.sending) {
+        _sendReady.push_back(fd);
+    }
+    conn.pending.append(data, length);
+    conn.pendingLines++;
+    _queuedBytes += length;
+}
+
+size_t IoUring::getQueuedBytes(int fd) const {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached) {
+        return 0;
+    }
+    return _conns[fd].pending.size() + _conns[fd].inflight.size();
+}
+
+size_t IoUring::getPendingBytes(int fd) const {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached || _conns[fd].sending) {
+        return 0;
+    }
+    return _conns[fd].pending.size();
+}
+
+size_t IoUring::getQueuedBytes() const {
+    return _queuedBytes;
+}
+
+void IoUring::discardPending(int fd) {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached) {
+        return;
+    }
+    Connection& conn = _conns[fd];
+    _queuedBytes -= conn.pending.size();
+    conn.pending.clear();
+    conn.pendingLines = 0;
+}
+
+void IoUring::pauseRecv(int fd) {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached || _conns[fd].recvPaused) {
+        return;
+    }
+    Connection& conn = _conns[fd];
+    conn.recvPaused = true;
+    if (!conn.recvArmed) {
+        return;
+    }
+
+    // マルチショットrecvだけを取り消す（送信は続ける）
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = makeUserData(fd, conn.generation, OP_RECV);
+        sqe->user_data = makeUserData(fd, conn.generation, OP_CANCEL);
+    }
+}
+
+void IoUring::resumeRecv(int fd) {
+    if (fd < 0 || (size_t)fd >= _conns.size() || !_conns[fd].attached || !_conns[fd].recvPaused) {
+        return;
+    }
+    _conns[fd].recvPaused = false;
+    // 取り消しがまだ完了していなければ、-ECANCELEDの完了時に再登録する
+    if (!_conns[fd].recvArmed) {
+        armRecv(fd);
+    }
+}
+
+void IoUring::handleCompletion(unsigned long long userData, int res, unsigned flags) {
+    UringOp op = (UringOp)(userData & 0xff);
+    int fd = (int)((userData >> 8) & 0xffffff);
+    unsigned generation = (unsigned)(userData >> 32);
+    bool current = (size_t)fd < _conns.size() && _conns[fd].attached && _conns[fd].generation == generation;
+
+    switch (op) {
+        case OP_POLL: {
+            if (!_reactorQueued) {
+                UringEvent event;
+                event.type = URING_REACTOR;
+                event.fd = _reactorFd;
+                event.data = NULL;
+                event.len = 0;
+                event.bufferId = -1;
+                event.error = 0;
+                _events.push_back(event);
+                _reactorQueued = true;
+            }
+            if (!(flags & IORING_CQE_F_MORE)) {
+                armReactorPoll();
+            }
+            break;
+        }
+        case OP_RECV: {
+            int bufferId = (flags & IORING_CQE_F_BUFFER) ? (int)(flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+            if (!current) {
+                if (bufferId >= 0) {
+                    addBuffer(bufferId);
+                }
+                break;
+            }
+            UringEvent event;
+            event.fd = fd;
+            event.data = NULL;
+            event.len = 0;
+            event.bufferId = bufferId;
+            event.error = 0;
+            Connection& conn = _conns[fd];
+            if (!(flags & IORING_CQE_F_MORE)) {
+                conn.recvArmed = false;
+            }
+            if (res > 0) {
+                event.type = URING_RECV;
+                event.data = _bufPool + bufferId * BUFFER_BYTES;
+                event.len = res;
+                _events.push_back(event);
+                if (!conn.recvArmed && !conn.recvPaused) {
+                    armRecv(fd);
+                }
+            } else if (res == 0) {
+                event.type = URING_RECV;
+                _events.push_back(event);
+            } else if (res == -ENOBUFS || res == -ECANCELED) {
+                // バッファ枯渇: 処理後に返却されるので再登録のみ
+                // 取り消し: 停止中でなければ（取り消し完了前に再開された場合）再登録
+                if (!conn.recvArmed && !conn.recvPaused) {
+                    armRecv(fd);
+                }
+            } else {
+                event.type = URING_CLOSED;
+                event.error = -res;
+                _events.push_back(event);
+            }
+            break;
+        }
+        case OP_SEND: {
+            std::map<unsigned long long, OrphanSend>::iterator orphan = _orphanSends.find(userData);
+            if (orphan != _orphanSends.end()) {
+                // 切断後の送信: 部分送信なら残りを、完了したら未投入の分を続けて送る
+                OrphanSend& sending = orphan->second;
+                if (res > 0 && (size_t)res < sending.inflight.size()) {
+                    _queuedBytes -= res;
+                    sending.inflight.erase(0, res);
+                    submitOrphanSend(userData, sending);
+                } else if (res >= 0 && !sending.pending.empty()) {
+                    _queuedBytes -= sending.inflight.size();
+                    sending.inflight.clear();
+                    sending.inflight.swap(sending.pending);
+                    submitOrphanSend(userData, sending);
+                } else {
+                    closeOrphan(orphan);
+                }
+                break;
+            }
+            if (!current) {
+                break;
+            }
+            Connection& conn = _conns[fd];
+            conn.sending = false;
+            if (res < 0) {
+                _queuedBytes -= conn.inflight.size() + conn.pending.size();
+                conn.inflight.clear();
+                conn.pending.clear();
+                UringEvent event;
+                event.type = URING_CLOSED;
+                event.fd = fd;
+                event.data = NULL;
+                event.len = 0;
+                event.bufferId = -1;
+                event.error = -res;
+                _events.push_back(event);
+            } else if ((size_t)res < conn.inflight.size()) {
+                // 部分送信: 残りを再投入
+                _queuedBytes -= res;
+                conn.inflight.erase(0, res);
+                submitSend(fd);
+            } else {
+                _queuedBytes -= conn.inflight.size();
+                conn.inflight.clear();
+                IoStats::instance().linesWritten += conn.inflightLines;
+                conn.inflightLines = 0;
+                if (!conn.pending.empty()) {
+                    _sendReady.push_back(fd);
+                }
+            }
+            break;
+        }
+        case OP_TIMEOUT: {
+            // 切断後の送信が期限内に終わらなければ取り消す（完了時にfdを閉じる）
+            std::map<unsigned long long, OrphanSend>::iterator orphan =
+                _orphanSends.find((userData & ~0xffULL) | OP_SEND);
+            if (res != -ETIME || orphan == _orphanSends.end()) {
+                break;
+            }
+            struct io_uring_sqe* sqe = getSqe();
+            if (sqe) {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = orphan->first;
+                sqe->user_data = (userData & ~0xffULL) | OP_CANCEL;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int IoUring::wait(int timeoutMs) {
+    _events.clear();
+    _reactorQueued = false;
+
+    // ループ中に溜まった送信をまとめてSQへ
+    std::vector<int> ready;
+    ready.swap(_sendReady);
+    for (size_t i = 0; i < ready.size(); ++i) {
+        int fd = ready[i];
+        if ((size_t)fd < _conns.size() && _conns[fd].attached) {
+            submitSend(fd);
+        }
+    }
+
+    // 既に完了がある場合は待機しない
+    unsigned head = *_cqHead;
+    unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    int result = enter(head == tail ? 1 : 0, timeoutMs);
+    if (result < 0 && errno != ETIME && errno != EBUSY) {
+        return -1;
+    }
+
+    struct io_uring_cqe* cqes = (struct io_uring_cqe*)_cqes;
+    tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &cqes[head & *_cqMask];
+        handleCompletion(cqe->user_data, cqe->res, cqe->flags);
+        head++;
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+        tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    }
+    return _events.size();
+}
+
+const std::vector<UringEvent>& IoUring::getEvents() const {
+    return _events;
+}
+
+void IoUring::recycle(const UringEvent& event) {
+    if (event.bufferId >= 0) {
+        addBuffer(event.bufferId);
+    }
+}
+
+#else
+
+// io_uring無効時のスタブ（init()が失敗しReactorを使用する）
+IoUring::IoUring()
+    : _ringFd(-1), _sqEntries(0), _sqRing(NULL), _cqRing(NULL), _sqRingSize(0), _cqRingSize(0),
+      _sqes(NULL), _sqesSize(0), _sqHead(NULL), _sqTail(NULL), _sqMask(NULL), _sqArray(NULL),
+      _cqHead(NULL), _cqTail(NULL), _cqMask(NULL), _cqes(NULL), _sqLocalTail(0),
+      _bufRing(NULL), _bufRingSize(0), _bufPool(NULL), _bufTail(0),
+      _reactorFd(-1), _reactorQueued(false), _queuedBytes(0) {
+}
+
+IoUring::~IoUring() {
+}
+
+bool IoUring::isAvailable() {
+    return false;
+}
+
+bool IoUring::init(int reactorFd) {
+    _reactorFd = reactorFd;
+    return false;
+}
+
+void IoUring::attach(int) {
+}
+
+void IoUring::detach(int) {
+}
+
+void IoUring::queueSend(int, const char*, size_t) {
+}
+
+size_t IoUring::getQueuedBytes(int) const {
+    return 0;
+}
+
+size_t IoUring::getPendingBytes(int) const {
+    return 0;
+}
+
+size_t IoUring::getQueuedBytes() const {
+    return 0;
+}
+
+void IoUring::discardPending(int) {
+}
+
+void IoUring::pauseRecv(int) {
+}
+
+void IoUring::resumeRecv(int) {
+}
+
+int IoUring::wait(int) {
+    return 0;
+}
+
+const std::vector<UringEvent>& IoUring::getEvents() const {
+    return _events;
+}
+
+void IoUring::recycle(const UringEvent&) {
+}
+
+#endif
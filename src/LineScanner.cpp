@@ -0,0 +1,109 @@
+#include "../include/LineScanner.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define LINESCANNER_X86
+# include <immintrin.h>
+#endif
+
+// 1バイトずつ判定（SIMD版の端数処理にも使用）
+static size_t scanScalar(const char* data, size_t length, bool& special) {
+    for (size_t i = 0; i < length; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            return i;
+        }
+        if (c == '\033' || c == '\0') {
+            special = true;
+        }
+    }
+    return length;
+}
+
+#ifdef LINESCANNER_X86
+
+// ビットマスク内の一致位置を先頭から調べる（LFなら位置を返し、ESC/NULなら印を付けて続ける）
+static bool resolveMask(const char* block, unsigned mask, size_t& offset, bool& special) {
+    while (mask) {
+        int bit = __builtin_ctz(mask);
+        if (block[bit] == '\n') {
+            offset = bit;
+            return true;
+        }
+        special = true;
+        mask &= mask - 1;
+    }
+    return false;
+}
+
+# ifdef __SSE2__
+static size_t scanSse2(const char* data, size_t length, bool& special) {
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i esc = _mm_set1_epi8('\033');
+    const __m128i nul = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, lf),
+                       _mm_or_si128(_mm_cmpeq_epi8(chunk, esc), _mm_cmpeq_epi8(chunk, nul)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        size_t offset;
+        if (mask && resolveMask(data + i, mask, offset, special)) {
+            return i + offset;
+        }
+    }
+    return i + scanScalar(data + i, length - i, special);
+}
+# endif
+
+__attribute__((target("avx2")))
+static size_t scanAvx2(const char* data, size_t length, bool& special) {
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i esc = _mm256_set1_epi8('\033');
+    const __m256i nul = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, lf),
+                       _mm256_or_si256(_mm256_cmpeq_epi8(chunk, esc), _mm256_cmpeq_epi8(chunk, nul)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        size_t offset;
+        if (mask && resolveMask(data + i, mask, offset, special)) {
+            return i + offset;
+        }
+    }
+    return i + scanScalar(data + i, length - i, special);
+}
+
+#endif
+
+typedef size_t (*ScanFunction)(const char*, size_t, bool&);
+
+// CPUに合わせた実装を初回呼び出し時に選ぶ
+static ScanFunction selectScanner(const char*& name) {
+#ifdef LINESCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        name = "avx2";
+        return scanAvx2;
+    }
+# ifdef __SSE2__
+    name = "sse2";
+    return scanSse2;
+# endif
+#endif
+    name = "scalar";
+    return scanScalar;
+}
+
+static const char* g_backendName = NULL;
+static ScanFunction g_scan = selectScanner(g_backendName);
+
+size_t LineScanner::findLineEnd(const char* data, size_t length, bool& special) {
+    return g_scan(data, length, special);
+}
+
+const char* LineScanner::getBackendName() {
+    return g_backendName;
+}
@@ -0,0 +1,217 @@
+#include "../include/MaskList.hpp"
+#include "../include/Client.hpp"
+#include "../include/NameTable.hpp"
+
+MaskList::MaskList() : _longestNick(0), _longestHost(0), _longestUser(0), _memory(0) {
+}
+
+std::string MaskList::normalize(const std::string& mask) {
+    size_t bang = mask.find('!');
+    size_t at = mask.find('@', bang == std::string::npos ? 0 : bang);
+    std::string nick;
+    std::string user;
+    std::string host;
+
+    if (bang == std::string::npos && at == std::string::npos) {
+        // '.' を含めばホスト名、それ以外はニックネームとみなす
+        if (mask.find('.') != std::string::npos) {
+            host = mask;
+        } else {
+            nick = mask;
+        }
+    } else {
+        if (bang != std::string::npos) {
+            nick = mask.substr(0, bang);
+            user = mask.substr(bang + 1, at == std::string::npos ? std::string::npos : at - bang - 1);
+        } else {
+            user = mask.substr(0, at);
+        }
+        if (at != std::string::npos) {
+            host = mask.substr(at + 1);
+        }
+    }
+
+    return (nick.empty() ? "*" : nick) + "!" + (user.empty() ? "*" : user) + "@" + (host.empty() ? "*" : host);
+}
+
+void MaskList::index(size_t position) {
+    const MaskEntry& entry = _entries[position];
+    const std::string& nickPrefix = entry.nick.getPrefix();
+    const std::string& hostSuffix = entry.host.getSuffix();
+    const std::string& userPrefix = entry.user.getPrefix();
+
+    Buckets* buckets = NULL;
+    const std::string* key = NULL;
+    if (!nickPrefix.empty()) {
+        buckets = &_byNickPrefix;
+        key = &nickPrefix;
+        _longestNick = std::max(_longestNick, nickPrefix.length());
+    } else if (!hostSuffix.empty()) {
+        buckets = &_byHostSuffix;
+        key = &hostSuffix;
+        _longestHost = std::max(_longestHost, hostSuffix.length());
+    } else if (!userPrefix.empty()) {
+        buckets = &_byUserPrefix;
+        key = &userPrefix;
+        _longestUser = std::max(_longestUser, userPrefix.length());
+    } else {
+        _unindexed.push_back(position);
+        return;
+    }
+
+    std::vector<size_t>* bucket = buckets->find(*key);
+    if (!bucket) {
+        bucket = &buckets->insert(*key, std::vector<size_t>());
+    }
+    bucket->push_back(position);
+}
+
+void MaskList::rebuild() {
+    _byNickPrefix.clear();
+    _byHostSuffix.clear();
+    _byUserPrefix.clear();
+    _unindexed.clear();
+    _longestNick = 0;
+    _longestHost = 0;
+    _longestUser = 0;
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        index(i);
+    }
+}
+
+size_t MaskList::measureBuckets(const Buckets& buckets) {
+    size_t total = buckets.getMemoryUsage();
+    for (size_t i = 0; i < buckets.capacity(); ++i) {
+        if (buckets.isUsed(i)) {
+            total += buckets.keyAt(i).capacity() + buckets.valueAt(i).capacity() * sizeof(size_t);
+        }
+    }
+    return total;
+}
+
+// 変更は稀なので、そのたびに全体を計り直して保持する
+void MaskList::measure() {
+    size_t total = _entries.capacity() * sizeof(MaskEntry) + _unindexed.capacity() * sizeof(size_t);
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        const MaskEntry& entry = _entries[i];
+        total += entry.mask.capacity() + entry.setBy.capacity()
+               + entry.nick.getMemoryUsage() + entry.user.getMemoryUsage() + entry.host.getMemoryUsage();
+    }
+    total += measureBuckets(_byNickPrefix) + measureBuckets(_byHostSuffix) + measureBuckets(_byUserPrefix);
+    _memory = total;
+}
+
+bool MaskList::matchesEntry(size_t position, const std::string& nick,
+                            const std::string& user, const std::string& host) const {
+    const MaskEntry& entry = _entries[position];
+    return entry.nick.matches(nick) && entry.user.matches(user) && entry.host.matches(host);
+}
+
+// textの先頭（fromEndなら末尾）1文字, 2文字, ... で索引を引き、候補だけを照合する
+bool MaskList::matchesBucket(const Buckets& buckets, size_t longest, const std::string& text, bool fromEnd,
+                             const std::string& nick, const std::string& user, const std::string& host) const {
+    if (longest == 0) {
+        return false;
+    }
+    std::string folded = NameTable::casefold(text);
+    std::string key;
+    size_t limit = std::min(longest, folded.length());
+    for (size_t length = 1; length <= limit; ++length) {
+        key.assign(folded, fromEnd ? folded.length() - length : 0, length);
+        const std::vector<size_t>* bucket = buckets.find(key);
+        if (!bucket) {
+            continue;
+        }
+        for (size_t i = 0; i < bucket->size(); ++i) {
+            if (matchesEntry((*bucket)[i], nick, user, host)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool MaskList::add(const std::string& mask, const std::string& setBy) {
+    std::string normalized = normalize(mask);
+    if (contains(normalized)) {
+        return false;
+    }
+
+    size_t bang = normalized.find('!');
+    size_t at = normalized.find('@', bang);
+
+    MaskEntry entry;
+    entry.mask = normalized;
+    entry.setBy = setBy;
+    entry.setAt = time(NULL);
+    entry.nick.compile(normalized.substr(0, bang));
+    entry.user.compile(normalized.substr(bang + 1, at - bang - 1));
+    entry.host.compile(normalized.substr(at + 1));
+
+    _entries.push_back(entry);
+    index(_entries.size() - 1);
+    measure();
+    return true;
+}
+
+bool MaskList::remove(const std::string& mask) {
+    std::string normalized = normalize(mask);
+    for (std::vector<MaskEntry>::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        if (NameTable::equals(it->mask, normalized)) {
+            _entries.erase(it);
+            // 削除は稀なので、エントリ番号を詰めて索引を作り直す
+            rebuild();
+            measure();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MaskList::contains(const std::string& mask) const {
+    std::string normalized = normalize(mask);
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        if (NameTable::equals(_entries[i].mask, normalized)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MaskList::matches(const Client* client) const {
+    if (_entries.empty()) {
+        return false;
+    }
+
+    std::string nick = client->getNickname();
+    std::string user = client->getUsername();
+    std::string host = client->getHostname();
+
+    if (matchesBucket(_byNickPrefix, _longestNick, nick, false, nick, user, host) ||
+        matchesBucket(_byHostSuffix, _longestHost, host, true, nick, user, host) ||
+        matchesBucket(_byUserPrefix, _longestUser, user, false, nick, user, host)) {
+        return true;
+    }
+    for (size_t i = 0; i < _unindexed.size(); ++i) {
+        if (matchesEntry(_unindexed[i], nick, user, host)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<MaskEntry>& MaskList::getEntries() const {
+    return _entries;
+}
+
+size_t MaskList::size() const {
+    return _entries.size();
+}
+
+bool MaskList::empty() const {
+    return _entries.empty();
+}
+
+size_t MaskList::getMemoryUsage() const {
+    return _memory;
+}
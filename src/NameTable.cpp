@@ -0,0 +1,104 @@
+#include "../include/NameTable.hpp"
+
+NameTable::NameTable() {
+    // ID 0 は無効値として予約
+    Entry reserved;
+    reserved.key.hash = 0;
+    reserved.refs = 0;
+    _entries.push_back(reserved);
+}
+
+char NameTable::foldChar(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c + ('a' - 'A');
+    }
+    switch (c) {
+        case '[': return '{';
+        case ']': return '}';
+        case '\\': return '|';
+        case '~': return '^';
+        default: return c;
+    }
+}
+
+std::string NameTable::casefold(const std::string& name) {
+    std::string folded(name);
+    for (size_t i = 0; i < folded.length(); ++i) {
+        folded[i] = foldChar(folded[i]);
+    }
+    return folded;
+}
+
+bool NameTable::equals(const std::string& a, const std::string& b) {
+    if (a.length() != b.length()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.length(); ++i) {
+        if (foldChar(a[i]) != foldChar(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NameTable::makeKey(const std::string& name, NameKey& key) {
+    // 畳み込みと同時にFNV-1aでハッシュを計算
+    key.folded.resize(name.length());
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < name.length(); ++i) {
+        char c = foldChar(name[i]);
+        key.folded[i] = c;
+        hash = (hash ^ (unsigned char)c) * 16777619u;
+    }
+    key.hash = hash;
+}
+
+NameId NameTable::lookup(const std::string& name) const {
+    NameKey key;
+    makeKey(name, key);
+    const NameId* id = _index.find(key);
+    return id ? *id : INVALID_NAME_ID;
+}
+
+NameId NameTable::acquire(const std::string& name) {
+    NameKey key;
+    makeKey(name, key);
+    NameId* found = _index.find(key);
+    if (found) {
+        _entries[*found].refs++;
+        return *found;
+    }
+
+    NameId id;
+    if (!_freeIds.empty()) {
+        id = _freeIds.back();
+        _freeIds.pop_back();
+    } else {
+        id = _entries.size();
+        _entries.push_back(Entry());
+    }
+    _entries[id].key = key;
+    _entries[id].refs = 1;
+    _index.insert(key, id);
+    return id;
+}
+
+void NameTable::release(NameId id) {
+    if (id == INVALID_NAME_ID || id >= _entries.size() || _entries[id].refs == 0) {
+        std::cout << "\033[1;31m[ERROR] Releasing unknown name id " << id << "\033[0m" << std::endl;
+        return;
+    }
+    if (--_entries[id].refs == 0) {
+        _index.erase(_entries[id].key);
+        _entries[id].key.folded.clear();
+        _freeIds.push_back(id);
+    }
+}
+
+const std::string& NameTable::getFolded(NameId id) const {
+    return _entries[id].key.folded;
+}
+
+size_t NameTable::size() const {
+    return _index.size();
+}
@@ -1,8 +1,63 @@
 #include "../include/Parser.hpp"
 
-Parser::Parser(const std::string& message)
-    : _message(message), _valid(false)
+ParamList::ParamList() : _line(NULL), _count(0) {
+}
+
+ParamList::ParamList(const char* line, const MessageSlice* slices, size_t count)
+    : _line(line), _count(std::min(count, (size_t)MAX_MESSAGE_PARAMS))
 {
+    for (size_t i = 0; i < _count; ++i) {
+        _slices[i] = slices[i];
+    }
+}
+
+size_t ParamList::size() const {
+    return _count;
+}
+
+bool ParamList::empty() const {
+    return _count == 0;
+}
+
+std::string ParamList::operator[](size_t index) const {
+    if (index >= _count) {
+        return std::string();
+    }
+    return std::string(_line + _slices[index].offset, _slices[index].length);
+}
+
+const char* ParamList::data(size_t index) const {
+    if (index >= _count) {
+        return "";
+    }
+    return _line + _slices[index].offset;
+}
+
+size_t ParamList::length(size_t index) const {
+    if (index >= _count) {
+        return 0;
+    }
+    return _slices[index].length;
+}
+
+bool ParamList::equals(size_t index, const char* value) const {
+    size_t valueLength = strlen(value);
+    return length(index) == valueLength && memcmp(data(index), value, valueLength) == 0;
+}
+
+ParamList ParamList::shift(size_t count) const {
+    if (count >= _count) {
+        return ParamList();
+    }
+    return ParamList(_line, _slices + count, _count - count);
+}
+
+Parser::Parser(const char* message, size_t length)
+    : _message(message), _length(length), _paramCount(0), _valid(false)
+{
+    _prefix.offset = 0;
+    _prefix.length = 0;
+    _command[0] = '\0';
     parse();
 }
 
@@ -10,122 +65,104 @@ Parser::~Parser() {
     // 特に何もしない
 }
 
-void Parser::parse() {
-    std::string msg = _message;
+size_t Parser::skipSpaces(size_t pos) const {
+    while (pos < _length && _message[pos] == ' ') {
+        pos++;
+    }
+    return pos;
+}
 
+size_t Parser::findSpace(size_t pos) const {
+    const char* space = static_cast<const char*>(memchr(_message + pos, ' ', _length - pos));
+    return space ? (size_t)(space - _message) : _length;
+}
+
+void Parser::parse() {
     // 空メッセージのチェック
-    if (msg.empty()) {
+    if (_length == 0) {
         _valid = false;
         return;
     }
 
     // メッセージの最大長をチェック（過剰に長いメッセージを防ぐ）
-    if (msg.length() > 512) {
+    if (_length > 512) {
         std::cout << "\033[1;31m[PARSER] Message too long, truncating to 512 characters\033[0m" << std::endl;
-        msg = msg.substr(0, 512);
+        _length = 512;
     }
 
     // 不正な制御文字をチェック
-    for (size_t i = 0; i < msg.length(); ++i) {
+    for (size_t i = 0; i < _length; ++i) {
         // NUL, CR, LF以外の制御文字をフィルタリング
-        if (msg[i] < 32 && msg[i] != '\r' && msg[i] != '\n') {
+        if (_message[i] < 32 && _message[i] != '\r' && _message[i] != '\n') {
             std::cout << "\033[1;31m[PARSER] Invalid control character at position " << i << "\033[0m" << std::endl;
             _valid = false;
             return;
         }
     }
 
+    // 文字列は作らず、読み取り位置を進めながら各要素の位置と長さを記録する
+    size_t pos = 0;
+
     // プレフィックスの抽出（オプション）
-    if (msg[0] == ':') {
-        size_t spacePos = msg.find(' ');
-        if (spacePos == std::string::npos) {
+    if (_message[0] == ':') {
+        size_t spacePos = findSpace(0);
+        if (spacePos == _length) {
             _valid = false;
             return;
         }
 
-        _prefix = msg.substr(1, spacePos - 1);
+        _prefix.offset = 1;
+        _prefix.length = spacePos - 1;
 
         // プレフィックスの形式チェック（空でないことを確認）
-        if (_prefix.empty()) {
+        if (_prefix.length == 0) {
             std::cout << "\033[1;31m[PARSER] Empty prefix\033[0m" << std::endl;
             _valid = false;
             return;
         }
 
-        msg = msg.substr(spacePos + 1);
-
-        // 空白削除
-        while (!msg.empty() && msg[0] == ' ') {
-            msg = msg.substr(1);
-        }
+        pos = skipSpaces(spacePos + 1);
     }
 
     // コマンドの抽出
-    size_t spacePos = msg.find(' ');
-    if (spacePos == std::string::npos) {
-        _command = Utils::toUpper(msg);
-
-        // コマンド名のバリデーション
-        if (_command.empty() || _command.length() > 16) {
-            std::cout << "\033[1;31m[PARSER] Invalid command name: '" << _command << "'\033[0m" << std::endl;
-            _valid = false;
-            return;
-        }
-
-        _valid = true;
-        return;
-    }
-
-    _command = Utils::toUpper(msg.substr(0, spacePos));
+    size_t commandEnd = findSpace(pos);
+    size_t commandLength = commandEnd - pos;
 
     // コマンド名のバリデーション
-    if (_command.empty() || _command.length() > 16) {
-        std::cout << "\033[1;31m[PARSER] Invalid command name: '" << _command << "'\033[0m" << std::endl;
+    if (commandLength == 0 || commandLength > MAX_COMMAND_LENGTH) {
+        std::cout << "\033[1;31m[PARSER] Invalid command name: '" << std::string(_message + pos, commandLength) << "'\033[0m" << std::endl;
         _valid = false;
         return;
     }
-
-    msg = msg.substr(spacePos + 1);
-
-    // 空白削除
-    while (!msg.empty() && msg[0] == ' ') {
-        msg = msg.substr(1);
+    for (size_t i = 0; i < commandLength; ++i) {
+        _command[i] = toupper((unsigned char)_message[pos + i]);
     }
+    _command[commandLength] = '\0';
+
+    pos = skipSpaces(commandEnd);
 
     // パラメータの抽出
-    size_t paramCount = 0;
-    while (!msg.empty() && paramCount < 15) { // 最大15個のパラメータに制限
+    while (pos < _length && _paramCount < MAX_MESSAGE_PARAMS) { // 最大15個のパラメータに制限
         // 最後のパラメータが':'で始まる場合（残りのすべてを1つのパラメータとして処理）
-        if (msg[0] == ':') {
-            _params.push_back(msg.substr(1));
-            paramCount++;
+        if (_message[pos] == ':') {
+            _params[_paramCount].offset = pos + 1;
+            _params[_paramCount].length = _length - pos - 1;
+            _paramCount++;
+            pos = _length;
             break;
         }
 
         // 通常のパラメータ
-        spacePos = msg.find(' ');
-        if (spacePos == std::string::npos) {
-            _params.push_back(msg);
-            paramCount++;
-            break;
-        }
+        size_t spacePos = findSpace(pos);
+        _params[_paramCount].offset = pos;
+        _params[_paramCount].length = spacePos - pos;
+        _paramCount++;
 
-        std::string param = msg.substr(0, spacePos);
-        if (!param.empty()) {
-            _params.push_back(param);
-            paramCount++;
-        }
-
-        msg = msg.substr(spacePos + 1);
-
-        // 空白削除
-        while (!msg.empty() && msg[0] == ' ') {
-            msg = msg.substr(1);
-        }
+        pos = skipSpaces(spacePos);
     }
 
     // 過剰なパラメータ数のチェック
-    if (!msg.empty() && paramCount >= 15) {
+    if (pos < _length && _paramCount >= MAX_MESSAGE_PARAMS) {
         std::cout << "\033[1;31m[PARSER] Too many parameters (max 15), truncating\033[0m" << std::endl;
     }
 
@@ -133,15 +170,19 @@ void Parser::parse() {
 }
 
 std::string Parser::getPrefix() const {
-    return _prefix;
+    return std::string(_message + _prefix.offset, _prefix.length);
 }
 
 std::string Parser::getCommand() const {
     return _command;
 }
 
-std::vector<std::string> Parser::getParams() const {
-    return _params;
+const char* Parser::getCommandName() const {
+    return _command;
+}
+
+ParamList Parser::getParams() const {
+    return ParamList(_message, _params, _paramCount);
 }
 
 bool Parser::isValid() const {
@@ -149,12 +190,13 @@ bool Parser::isValid() const {
 }
 
 void Parser::printParsedMessage() const {
-    std::cout << "Message: " << _message << std::endl;
-    std::cout << "Prefix: " << _prefix << std::endl;
+    std::cout << "Message: " << std::string(_message, _length) << std::endl;
+    std::cout << "Prefix: " << getPrefix() << std::endl;
     std::cout << "Command: " << _command << std::endl;
     std::cout << "Params: ";
-    for (std::vector<std::string>::const_iterator it = _params.begin(); it != _params.end(); ++it) {
-        std::cout << "[" << *it << "] ";
+    ParamList params = getParams();
+    for (size_t i = 0; i < params.size(); ++i) {
+        std::cout << "[" << params[i] << "] ";
     }
     std::cout << std::endl;
     std::cout << "Valid: " << (_valid ? "true" : "false") << std::endl;
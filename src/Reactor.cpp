@@ -0,0 +1,273 @@
+#include "../include/Reactor.hpp"
+
+IoStats& IoStats::instance() {
+    static IoStats stats = IoStats();
+    return stats;
+}
+
+unsigned long IoStats::totalSyscalls() const {
+    return waitCalls + recvCalls + sendCalls;
+}
+
+double IoStats::syscallsPerMessage() const {
+    unsigned long messages = messagesIn + messagesOut;
+    if (messages == 0) {
+        return 0.0;
+    }
+    return (double)totalSyscalls() / messages;
+}
+
+double IoStats::linesPerWrite() const {
+    if (writeBatches == 0) {
+        return 0.0;
+    }
+    return (double)linesWritten / writeBatches;
+}
+
+static const char* fdKindToString(FdKind kind) {
+    switch (kind) {
+        case FD_LISTENER: return "listener";
+        case FD_CLIENT: return "client";
+        case FD_DCC_LISTEN: return "dcc-listen";
+        case FD_DCC_DATA: return "dcc-data";
+        case FD_CONSOLE: return "console";
+        default: return "none";
+    }
+}
+
+#ifdef __linux__
+static uint32_t toEpollEvents(short events) {
+    uint32_t result = 0;
+    if (events & POLLIN) {
+        result |= EPOLLIN;
+    }
+    if (events & POLLOUT) {
+        result |= EPOLLOUT;
+    }
+    return result;
+}
+#endif
+
+Reactor::Reactor() : _watchedCount(0)
+#ifdef __linux__
+    , _epollFd(-1)
+#endif
+{
+}
+
+Reactor::~Reactor() {
+#ifdef __linux__
+    if (_epollFd >= 0) {
+        close(_epollFd);
+        _epollFd = -1;
+    }
+#endif
+}
+
+bool Reactor::init() {
+#ifdef __linux__
+    _epollFd = epoll_create(1);
+    if (_epollFd < 0) {
+        std::cout << "\033[1;31m[ERROR] epoll_create() failed: " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+    fcntl(_epollFd, F_SETFD, FD_CLOEXEC);
+    _epollEvents.resize(64);
+#endif
+    std::cout << "\033[1;36m[REACTOR] Using " << getBackendName() << " backend\033[0m" << std::endl;
+    return true;
+}
+
+bool Reactor::add(int fd, FdKind kind, short events, Client* client, DCCTransfer* transfer) {
+    if (fd < 0) {
+        return false;
+    }
+
+    // ハンドラテーブルを必要に応じて拡張
+    if ((size_t)fd >= _handlers.size()) {
+        FdHandler empty;
+        empty.kind = FD_NONE;
+        empty.events = 0;
+        empty.client = NULL;
+        empty.transfer = NULL;
+        _handlers.resize(fd + 1, empty);
+    }
+
+    // 既に登録済みの場合はハンドラとイベントを更新
+    if (_handlers[fd].kind != FD_NONE) {
+        _handlers[fd].kind = kind;
+        _handlers[fd].client = client;
+        _handlers[fd].transfer = transfer;
+        return modify(fd, events);
+    }
+
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = toEpollEvents(events);
+    ev.data.fd = fd;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        std::cout << "\033[1;31m[ERROR] epoll_ctl(ADD) failed for fd " << fd << ": " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+#else
+    if ((size_t)fd >= _pollIndex.size()) {
+        _pollIndex.resize(fd + 1, -1);
+    }
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    _pollIndex[fd] = _pollfds.size();
+    _pollfds.push_back(pfd);
+#endif
+
+    _handlers[fd].kind = kind;
+    _handlers[fd].events = events;
+    _handlers[fd].client = client;
+    _handlers[fd].transfer = transfer;
+    _watchedCount++;
+
+    std::cout << "\033[1;36m[REACTOR] Watching fd " << fd << " (" << fdKindToString(kind) << "), "
+              << _watchedCount << " file descriptors monitored\033[0m" << std::endl;
+    return true;
+}
+
+bool Reactor::modify(int fd, short events) {
+    if (fd < 0 || (size_t)fd >= _handlers.size() || _handlers[fd].kind == FD_NONE) {
+        return false;
+    }
+    if (_handlers[fd].events == events) {
+        return true;
+    }
+
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = toEpollEvents(events);
+    ev.data.fd = fd;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        std::cout << "\033[1;31m[ERROR] epoll_ctl(MOD) failed for fd " << fd << ": " << strerror(errno) << "\033[0m" << std::endl;
+        return false;
+    }
+#else
+    _pollfds[_pollIndex[fd]].events = events;
+#endif
+
+    _handlers[fd].events = events;
+    return true;
+}
+
+void Reactor::remove(int fd) {
+    if (fd < 0 || (size_t)fd >= _handlers.size() || _handlers[fd].kind == FD_NONE) {
+        return;
+    }
+
+#ifdef __linux__
+    // close()前に呼ばれる前提。失敗しても登録情報は破棄する
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &ev);
+#else
+    // 末尾要素と入れ替えて削除（O(1)）
+    int index = _pollIndex[fd];
+    int lastFd = _pollfds.back().fd;
+    _pollfds[index] = _pollfds.back();
+    _pollIndex[lastFd] = index;
+    _pollfds.pop_back();
+    _pollIndex[fd] = -1;
+#endif
+
+    FdKind kind = _handlers[fd].kind;
+    _handlers[fd].kind = FD_NONE;
+    _handlers[fd].events = 0;
+    _handlers[fd].client = NULL;
+    _handlers[fd].transfer = NULL;
+    _watchedCount--;
+
+    std::cout << "\033[1;36m[REACTOR] Stopped watching fd " << fd << " (" << fdKindToString(kind) << "), "
+              << _watchedCount << " file descriptors monitored\033[0m" << std::endl;
+}
+
+const FdHandler* Reactor::getHandler(int fd) const {
+    if (fd < 0 || (size_t)fd >= _handlers.size() || _handlers[fd].kind == FD_NONE) {
+        return NULL;
+    }
+    return &_handlers[fd];
+}
+
+int Reactor::wait(int timeoutMs) {
+    _ready.clear();
+
+#ifdef __linux__
+    // 前回バッファが埋まった場合は拡張
+    if (_epollEvents.size() < _watchedCount && _epollEvents.size() < 4096) {
+        _epollEvents.resize(std::min(_watchedCount, (size_t)4096));
+    }
+
+    IoStats::instance().waitCalls++;
+    int count = epoll_wait(_epollFd, &_epollEvents[0], _epollEvents.size(), timeoutMs);
+    if (count < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        ReadyEvent ready;
+        ready.fd = _epollEvents[i].data.fd;
+        ready.readable = (_epollEvents[i].events & EPOLLIN) != 0;
+        ready.writable = (_epollEvents[i].events & EPOLLOUT) != 0;
+        ready.error = (_epollEvents[i].events & (EPOLLHUP | EPOLLERR)) != 0;
+        _ready.push_back(ready);
+    }
+#else
+    if (_pollfds.empty()) {
+        return 0;
+    }
+
+    IoStats::instance().waitCalls++;
+    int count = poll(&_pollfds[0], _pollfds.size(), timeoutMs);
+    if (count < 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < _pollfds.size() && _ready.size() < (size_t)count; ++i) {
+        short revents = _pollfds[i].revents;
+        if (revents == 0) {
+            continue;
+        }
+        ReadyEvent ready;
+        ready.fd = _pollfds[i].fd;
+        ready.readable = (revents & POLLIN) != 0;
+        ready.writable = (revents & POLLOUT) != 0;
+        ready.error = (revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+        _ready.push_back(ready);
+        _pollfds[i].revents = 0;
+    }
+#endif
+
+    return _ready.size();
+}
+
+const std::vector<ReadyEvent>& Reactor::getReadyEvents() const {
+    return _ready;
+}
+
+int Reactor::getFd() const {
+#ifdef __linux__
+    return _epollFd;
+#else
+    return -1;
+#endif
+}
+
+size_t Reactor::getWatchedCount() const {
+    return _watchedCount;
+}
+
+const char* Reactor::getBackendName() const {
+#ifdef __linux__
+    return "epoll";
+#else
+    return "poll";
+#endif
+}
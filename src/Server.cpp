@@ -3,9 +3,12 @@
 #include "../include/bonus/BotManager.hpp"
 #include "../include/DCCManager.hpp"
 #include "../include/DCCTransfer.hpp"
+#include <fstream>
+#include <cctype>
+#include <functional>
 
 Server::Server(int port, const std::string& password)
-    : _serverSocket(-1), _password(password), _port(port), _running(false), _commandFactory(NULL), _botManager(NULL), _dccManager(NULL)
+    : _serverSocket(-1), _password(password), _port(port), _clientPool("client"), _channelPool("channel"), _ioUring(NULL), _running(false), _commandFactory(NULL), _botManager(NULL), _dccManager(NULL)
 {
     char hostname[1024];
     if (gethostname(hostname, sizeof(hostname)) == 0) {
@@ -19,6 +22,86 @@ Server::Server(int port, const std::string& password)
     }
 
     _startTime = time(NULL);
+
+    // listen()のバックログ（SOMAXCONNを超える値はカーネル側で切り詰められる）
+    _listenBacklog = Utils::getEnvInt("IRC_LISTEN_BACKLOG", DEFAULT_LISTEN_BACKLOG, 1, 65535);
+
+    _acceptStats.accepted = 0;
+    _acceptStats.capHits = 0;
+    _acceptStats.windowCount = 0;
+    _acceptStats.windowStart = _startTime;
+    _acceptStats.perSecond = 0.0;
+    _acceptStats.overflowBase = readListenOverflows();
+    _statusTimer.setHandler(this);
+
+    // キープアライブ設定
+    _pingInterval = Utils::getEnvInt("IRC_PING_INTERVAL", DEFAULT_PING_INTERVAL, 5, 86400);
+    _pingTimeout = Utils::getEnvInt("IRC_PING_TIMEOUT", DEFAULT_PING_TIMEOUT, 1, 86400);
+    _keepaliveStats.pingsSent = 0;
+    _keepaliveStats.pongsMatched = 0;
+    _keepaliveStats.timeouts = 0;
+    _keepaliveStats.rttNext = 0;
+
+    // コマンドスケジューラ（クライアントごとの1回の行数と、イテレーションごとのコマンドの重みの合計）
+    _linesPerTurn = Utils::getEnvInt("IRC_LINES_PER_TURN", DEFAULT_LINES_PER_TURN, 1, 100000);
+    _workPerIteration = Utils::getEnvInt("IRC_WORK_PER_ITERATION", DEFAULT_WORK_PER_ITERATION, 1, 1000000);
+    _schedulerStats.iterations = 0;
+    _schedulerStats.lastWork = 0;
+    _schedulerStats.maxWork = 0;
+    _schedulerStats.totalWork = 0;
+    _schedulerStats.budgetHits = 0;
+    _schedulerStats.maxQueued = 0;
+    _schedulerStats.maxWaitMs = 0;
+    _schedulerStats.recentMaxWaitMs = 0;
+
+    // フラッド制御（IRC_FLOOD_BURST/IRC_FLOOD_RATE、コマンドの重みはIRC_FLOOD_WEIGHTS）
+    _floodBurst = Utils::getEnvInt("IRC_FLOOD_BURST", DEFAULT_FLOOD_BURST, 1, 100000);
+    _floodRate = Utils::getEnvInt("IRC_FLOOD_RATE", DEFAULT_FLOOD_RATE, 1, 100000);
+    _floodStats.holds = 0;
+    _floodStats.deferredLines = 0;
+    _floodStats.heldClients = 0;
+
+    // 送信キューの上限（接続クラスごと、ウォーターマークは上限のSENDQ_WATERMARK_PERCENT%）
+    static const char* sendQNames[SENDQ_CLASS_COUNT] = { "unregistered", "user", "operator" };
+    static const char* sendQEnv[SENDQ_CLASS_COUNT] = { "IRC_SENDQ_UNREGISTERED_KB", "IRC_SENDQ_USER_KB", "IRC_SENDQ_OPERATOR_KB" };
+    static const int sendQDefaults[SENDQ_CLASS_COUNT] = { DEFAULT_SENDQ_UNREGISTERED_KB, DEFAULT_SENDQ_USER_KB, DEFAULT_SENDQ_OPERATOR_KB };
+    for (int i = 0; i < SENDQ_CLASS_COUNT; ++i) {
+        _sendQClasses[i].name = sendQNames[i];
+        _sendQClasses[i].limit = (size_t)Utils::getEnvInt(sendQEnv[i], sendQDefaults[i], 4, 1048576) * 1024;
+        _sendQClasses[i].watermark = _sendQClasses[i].limit / 100 * SENDQ_WATERMARK_PERCENT;
+        _sendQClasses[i].exceeded = 0;
+        _sendQClasses[i].stalled = 0;
+    }
+    _sendQStallSeconds = Utils::getEnvInt("IRC_SENDQ_STALL_SECONDS", DEFAULT_SENDQ_STALL_SECONDS, 1, 86400);
+
+    // メモリ予算（超えそうになったら受信停止、超えたら送信キューの大きいクライアントを切断）
+    _memoryStats.budget = (size_t)Utils::getEnvInt("IRC_MEMORY_BUDGET_KB", DEFAULT_MEMORY_BUDGET_KB, 1024, 16777216) * 1024;
+    _memoryStats.peak = 0;
+    _memoryStats.underPressure = false;
+    _memoryStats.lastRebalance = 0;
+    _memoryStats.pausedClients = 0;
+    _memoryStats.pauses = 0;
+    _memoryStats.sheds = 0;
+
+    // ステータス表示設定（IRC_HEADLESS=1 で表示と端末操作を無効化）
+    _statusInterval = Utils::getEnvInt("IRC_STATUS_INTERVAL", DEFAULT_STATUS_INTERVAL, 100, 3600000);
+    _headless = Utils::getEnvInt("IRC_HEADLESS", 0, 0, 1) == 1;
+    _detailedView = false;
+    _consoleWatched = false;
+    _lastStatusRender = 0;
+
+    // IRC_DEBUG_CHECKS=1 でニックネーム索引の整合性を変更のたびに検証
+    _debugChecks = Utils::getEnvInt("IRC_DEBUG_CHECKS", 0, 0, 1) == 1;
+    _statusSnapshot.clients = 0;
+    _statusSnapshot.channels = 0;
+    _statusSnapshot.nicknames = 0;
+    _statusSnapshot.connects = 0;
+    _statusSnapshot.disconnects = 0;
+    _statusSnapshot.nickChanges = 0;
+    _statusSnapshot.version = 0;
+    _statusSnapshot.renderedVersion = 0;
+    _statusSnapshot.renders = 0;
+
     _commandFactory = new CommandFactory(this);
     _botManager = new BotManager(this);
     _dccManager = new DCCManager(this);
@@ -29,15 +112,18 @@ Server::~Server() {
 
     // クライアントの解放
     for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
-        delete it->second;
+        _clientPool.destroy(it->second);
     }
     _clients.clear();
 
     // チャンネルの解放
-    for (std::map<std::string, Channel*>::iterator it = _channels.begin(); it != _channels.end(); ++it) {
-        delete it->second;
+    for (size_t i = 0; i < _channels.capacity(); ++i) {
+        if (_channels.isUsed(i)) {
+            _channelPool.destroy(_channels.valueAt(i));
+        }
     }
     _channels.clear();
+    _nicknames.clear();
 
     // コマンドファクトリーの解放
     if (_commandFactory) {
@@ -56,11 +142,27 @@ Server::~Server() {
         delete _dccManager;
         _dccManager = NULL;
     }
+
+    // io_uringエンジンの解放（クライアントのclose後）
+    if (_ioUring) {
+        delete _ioUring;
+        _ioUring = NULL;
+    }
 }
 
 void Server::setup() {
     initializeSocket();
 
+    // io_uringが有効なビルドではクライアントI/Oをio_uringで処理（失敗時はReactorを使用）
+    if (IoUring::isAvailable()) {
+        _ioUring = new IoUring();
+        if (!_ioUring->init(_reactor.getFd())) {
+            std::cout << "\033[1;33m[WARNING] io_uring unavailable, falling back to " << _reactor.getBackendName() << "\033[0m" << std::endl;
+            delete _ioUring;
+            _ioUring = NULL;
+        }
+    }
+
     // SIGPIPEを無視
     signal(SIGPIPE, SIG_IGN);
     
@@ -71,52 +173,37 @@ void Server::setup() {
 
     std::cout << "\033[1;32m[SERVER] ft_irc server listening on port " << _port << "\033[0m" << std::endl;
 
+    if (_headless) {
+        std::cout << "\033[1;36m[STATUS] Headless mode: status display disabled\033[0m" << std::endl;
+        return;
+    }
+
+    // 端末から起動された場合は標準入力でステータス表示を操作できるようにする
+    if (isatty(STDIN_FILENO) && _reactor.add(STDIN_FILENO, FD_CONSOLE, POLLIN)) {
+        _consoleWatched = true;
+        std::cout << "\033[1;36m[STATUS] Console: 'd' + Enter toggles detailed view, 's' refreshes, 'h' shows help\033[0m" << std::endl;
+    }
+
     // 初期ステータス表示
-    displayServerStatus();
+    renderStatus();
 }
 
 void Server::run() {
     _running = true;
 
-    // 状態変化を追跡するための変数を初期化
-    size_t lastClientCount = _clients.size();
-    size_t lastChannelCount = _channels.size();
-    size_t lastNicknameCount = _nicknames.size();
-    time_t lastDisplayTime = time(NULL); // 最後に表示した時間を記録
-
+    // ステータス表示は状態変更時に_statusTimerで予約され、タイマー処理の中で行われる
     while (_running) {
-        // 現在の時間を取得
-        time_t currentTime = time(NULL);
-
-        // クライアント数、チャンネル数、ニックネーム数のいずれかが変わった場合にのみステータスを更新
-        // かつ、最後の表示から少なくとも1秒経過している場合のみ表示する
-        if (((_clients.size() != lastClientCount ||
-             _channels.size() != lastChannelCount ||
-             _nicknames.size() != lastNicknameCount) &&
-             (currentTime - lastDisplayTime >= 1)))
-        {
-            // 空のチャンネルをチェックして削除（ステータス表示前に）
-            checkAndRemoveEmptyChannels();
-
-            displayServerStatus();
-            // 現在の状態を保存
-            lastClientCount = _clients.size();
-            lastChannelCount = _channels.size();
-            lastNicknameCount = _nicknames.size();
-            lastDisplayTime = currentTime;
-        }
-
-        // pollfdの更新
-        updatePollFds();
-
-        // poll関数でイベントを監視（例外処理を追加）
-        int pollResult = 0;
-        try {
-            pollResult = poll(&_pollfds[0], _pollfds.size(), 1000); // 1秒のタイムアウト
-        } catch (const std::exception& e) {
-            std::cerr << "\033[1;31m[ERROR] Exception in poll(): " << e.what() << "\033[0m" << std::endl;
-            continue;
-        }
+        // 前回のイテレーションの一時データを破棄（確保済みの領域は使い回す）
+        _arena.reset();
+
+        // 前回のイテレーションで生成された応答をクライアントごとにまとめて送信してから待機
+        flushPendingOutput();
+
+        // 次のタイマー満了まで待機して準備完了したfdのみを処理（タイマーがなければ無期限）
+        // 続きを送れるWHOが残っている場合は待たずに次へ進む
+        // 実行待ちの行が残っている場合も同様
+        int timeoutMs = (hasRunnableWhoQuery() || !_runQueue.empty()) ? 0 : _timers.nextTimeoutMs(TimerWheel::nowMs());
+        int pollResult = waitForEvents(timeoutMs);
 
         if (pollResult < 0) {
             if (errno == EINTR) {
@@ -127,76 +214,24 @@ void Server::run() {
             break;
         }
 
-        // 各ファイルディスクリプタのイベントを処理
-        for (size_t i = 0; i < _pollfds.size(); i++) {
-            // 安全チェック：無効なfdをスキップ
-            if (_pollfds[i].fd < 0) {
-                continue;
-            }
+        // 満了したタイマーを処理（タイムアウトしたクライアントは切断予約される）
+        _timers.advance(TimerWheel::nowMs());
 
-            if (_pollfds[i].revents & (POLLIN | POLLOUT)) {
-                if (_pollfds[i].fd == _serverSocket) {
-                    // 新しい接続を処理
-                    if (_pollfds[i].revents & POLLIN) {
-                        handleNewConnection();
-                    }
-                } else if (getClientByFd(_pollfds[i].fd)) {
-                    // クライアントからのデータを処理
-                    if (_pollfds[i].revents & POLLIN) {
-                        handleClientData(i);
-                    }
-                } else if (_dccManager) {
-                    // DCC転送ソケットのイベントを処理
-                    std::vector<DCCTransfer*> transfers = _dccManager->getActiveTransfers();
-                    for (size_t j = 0; j < transfers.size(); ++j) {
-                        DCCTransfer* transfer = transfers[j];
-                        
-                        // リスニングソケットでの接続受け入れ
-                        if (transfer->getListenSocket() == _pollfds[i].fd && (_pollfds[i].revents & POLLIN)) {
-                            std::cout << "[DCC] Incoming connection on listening socket" << std::endl;
-                            if (transfer->acceptConnection()) {
-                                std::cout << "[DCC] Connection accepted, transfer is now active" << std::endl;
-                                // データソケットをDCCManagerに登録
-                                if (transfer->getDataSocket() >= 0) {
-                                    _dccManager->addTransferSocket(transfer->getDataSocket(), transfer);
-                                }
-                            }
-                        }
-                        // データ転送の処理
-                        else if (transfer->getDataSocket() == _pollfds[i].fd) {
-                            if (_pollfds[i].revents & (POLLIN | POLLOUT)) {
-                                transfer->processTransfer();
-                            }
-                        }
-                    }
-                }
-            }
+        // トークンが貯まったクライアントの保留を解除して実行待ちへ
+        resumeHeldInput();
 
-            // エラーや切断を処理
-            if (_pollfds[i].revents & (POLLHUP | POLLERR)) {
-                if (_pollfds[i].fd != _serverSocket) {
-                    // クライアントが存在するかチェック
-                    if (getClientByFd(_pollfds[i].fd)) {
-                        // クライアントを削除
-                        removeClient(_pollfds[i].fd);
-                        // インデックスを調整（削除したので）
-                        i--;
-                    } else {
-                        // DCCソケットの切断を処理
-                        std::cout << "[DCC] Socket error/disconnect on fd: " << _pollfds[i].fd << std::endl;
-                        removePollFd(_pollfds[i].fd);
-                        i--;
-                    }
-                }
-            }
-        }
+        // 受信済みの行をクライアントごとに順番に実行
+        runScheduledClients();
+
+        // メモリ予算を確認（超過時の切断は直後の削除でまとめて行う）
+        checkMemoryPressure();
 
-        // 切断されたクライアントをチェック
+        // 切断予約されたクライアントを削除
         checkDisconnectedClients();
 
-        // 空のチャンネルをチェックして削除
-        checkAndRemoveEmptyChannels();
-        
+        // 途中まで送ったWHOの続きを処理
+        continueWhoQueries();
+
         // DCC転送を処理
         if (_dccManager) {
             _dccManager->processTransfers();
@@ -208,9 +243,16 @@ void Server::stop() {
     _running = false;
 
     if (_serverSocket >= 0) {
+        _reactor.remove(_serverSocket);
         close(_serverSocket);
         _serverSocket = -1;
     }
+
+    // 標準入力は閉じずに監視のみ解除
+    if (_consoleWatched) {
+        _reactor.remove(STDIN_FILENO);
+        _consoleWatched = false;
+    }
 }
 
 Client* Server::getClientByFd(int fd) {
@@ -222,22 +264,41 @@ Client* Server::getClientByFd(int fd) {
 }
 
 Client* Server::getClientByNickname(const std::string& nickname) {
-    std::map<std::string, Client*>::iterator it = _nicknames.find(nickname);
-    if (it != _nicknames.end()) {
-        return it->second;
+    NameId id = _names.lookup(nickname);
+    if (id == INVALID_NAME_ID) {
+        return NULL;
     }
-    return NULL;
+    Client** client = _nicknames.find(id);
+    return client ? *client : NULL;
 }
 
 void Server::addClient(int fd, const std::string& hostname) {
-    Client* client = new Client(fd, hostname);
+    Client* client = new (_clientPool.allocate()) Client(fd, hostname, this);
     _clients[fd] = client;
 
-    // ファイルディスクリプタをノンブロッキングに設定
-    setNonBlocking(fd);
+    // TCP_NODELAYの設定（応答はループ毎にwritevでまとめて送るため、Nagleの遅延は不要）
+    int opt = 1;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
+        std::cout << "\033[1;33m[WARNING] setsockopt(TCP_NODELAY) failed for fd " << fd << ": " << strerror(errno) << "\033[0m" << std::endl;
+        // 致命的でないためcontinue
+    }
+
+    // 読み込みイベントの監視を開始
+    if (_ioUring) {
+        _ioUring->attach(fd);
+    } else {
+        _reactor.add(fd, FD_CLIENT, POLLIN, client);
+    }
 
     std::cout << "\033[1;32m[+] New client connected: " << fd << " from " << hostname << "\033[0m" << std::endl;
-    displayServerStatus();
+
+    // ステータスは集計のみ更新し、表示は間隔ごとにまとめて行う
+    _statusSnapshot.clients = _clients.size();
+    _statusSnapshot.connects++;
+    std::stringstream log;
+    log << "fd " << fd << " connected from " << hostname;
+    addConnectionLog(log.str(), "\033[1;32m");
+    markStatusDirty();
 }
 
 void Server::removeClient(int fd) {
@@ -247,27 +308,27 @@ void Server::removeClient(int fd) {
         if (!client->getNickname().empty()) {
             std::cout << " (" << client->getNickname() << ")";
 
-            // ニックネームマップから削除
-            std::string nickname = client->getNickname();
-            if (_nicknames.find(nickname) != _nicknames.end()) {
-                std::cout << "\n\033[1;35m[NICKMAP] Removing nickname: " << nickname << "\033[0m";
-                _nicknames.erase(nickname);
-            }
+        }
+        std::cout << "\033[0m" << std::endl;
 
-            // 古いニックネーム削除処理
-            std::vector<std::string> nicksToRemove;
-            for (std::map<std::string, Client*>::iterator it = _nicknames.begin(); it != _nicknames.end(); ++it) {
-                if (it->second == client) {
-                    nicksToRemove.push_back(it->first);
-                }
-            }
+        // ニックネームマップから削除（クライアントが自分のエントリを保持している）
+        NameId nickId = client->getNickId();
+        if (nickId != INVALID_NAME_ID) {
+            std::cout << "\033[1;35m[NICKMAP] Removing nickname: " << client->getNickname() << "\033[0m" << std::endl;
+            _nickOrder.erase(_names.getFolded(nickId));
+            _nicknames.erase(nickId);
+            _names.release(nickId);
+            client->setNickId(INVALID_NAME_ID);
+        }
 
-            for (std::vector<std::string>::iterator it = nicksToRemove.begin(); it != nicksToRemove.end(); ++it) {
-                std::cout << "\n\033[1;35m[NICKMAP] Removing stale nickname: " << *it << "\033[0m";
-                _nicknames.erase(*it);
+        // 送信途中のWHOを破棄
+        for (std::deque<WhoQuery>::iterator it = _whoQueue.begin(); it != _whoQueue.end(); ) {
+            if (it->getRequester() == client) {
+                it = _whoQueue.erase(it);
+            } else {
+                ++it;
             }
         }
-        std::cout << "\033[0m" << std::endl;
 
         // DCC転送をクリーンアップ
         if (_dccManager) {
@@ -275,28 +336,50 @@ void Server::removeClient(int fd) {
         }
         
         // チャンネルからクライアントを削除（クライアント削除前にコピー）
-        std::vector<std::string> channels = client->getChannels();
-        for (std::vector<std::string>::iterator it = channels.begin(); it != channels.end(); ++it) {
+        std::vector<NameId> channels = client->getChannels();
+        for (std::vector<NameId>::iterator it = channels.begin(); it != channels.end(); ++it) {
             Channel* channel = getChannel(*it);
             if (channel) {
-                std::cout << "\033[1;33m[CHANNEL] Removing client " << client->getNickname() << " from channel " << *it << "\033[0m" << std::endl;
+                std::cout << "\033[1;33m[CHANNEL] Removing client " << client->getNickname() << " from channel " << channel->getName() << "\033[0m" << std::endl;
+                // 最後の参加者だった場合はチャンネルもここで破棄される
                 channel->removeClient(client);
-                // ここではチャンネル削除を行わない
             }
         }
 
-        // クライアントの削除
-        delete client;
-        _clients.erase(fd);
+        // 残っている送信キューを可能な範囲で書き出す（QUITの応答など）
+        client->flushOutput();
 
-        // pollFDの削除
-        removePollFd(fd);
+        if (client->isReadPaused()) {
+            _memoryStats.pausedClients--;
+        }
+        if (client->isFloodHeld()) {
+            _floodStats.heldClients--;
+        }
 
-        // チャンネル削除処理（一括で行う）
-        checkAndRemoveEmptyChannels();
+        // 監視対象から外してからクライアントを削除（close前にepoll/io_uringから登録解除）
+        if (_ioUring) {
+            _ioUring->detach(fd);
+        } else {
+            _reactor.remove(fd);
+        }
+        std::stringstream log;
+        log << "fd " << fd;
+        if (!client->getNickname().empty()) {
+            log << " (" << client->getNickname() << ")";
+        }
+        log << " disconnected";
+        _clientPool.destroy(client);
+        _clients.erase(fd);
 
-        // 状態表示更新
-        displayServerStatus();
+        // 集計を更新（表示は間隔ごとにまとめて行う）
+        _statusSnapshot.clients = _clients.size();
+        _statusSnapshot.nicknames = _nicknames.size();
+        _statusSnapshot.disconnects++;
+        addConnectionLog(log.str(), "\033[1;31m");
+        if (_debugChecks) {
+            verifyNicknameIndex(std::cout);
+        }
+        markStatusDirty();
     }
 }
 
@@ -310,117 +393,207 @@ void Server::removeClient(const std::string& nickname) {
 }
 
 bool Server::isNicknameInUse(const std::string& nickname) {
-    bool inUse = _nicknames.find(nickname) != _nicknames.end();
+    bool inUse = getClientByNickname(nickname) != NULL;
     std::cout << "\033[1;36m[NICKMAP] Checking if nickname '" << nickname << "' is in use: " << (inUse ? "YES" : "NO") << "\033[0m" << std::endl;
     return inUse;
 }
 
-void Server::updateNickname(const std::string& oldNick, const std::string& newNick) {
-    std::cout << "\033[1;35m[NICKMAP] Updating: '" << oldNick << "' -> '" << newNick << "'\033[0m" << std::endl;
-
-    // クライアントを特定
-    Client* client = NULL;
+void Server::updateNickname(Client* client, const std::string& newNick) {
+    NameId oldId = client->getNickId();
+    std::cout << "\033[1;35m[NICKMAP] Updating: '" << (oldId != INVALID_NAME_ID ? _names.getFolded(oldId) : "")
+              << "' -> '" << newNick << "'\033[0m" << std::endl;
+
+    // 先に新しい名前を確保してから古いエントリを外す（大文字小文字だけの変更では同じIDを使い続ける）
+    NameId newId = _names.acquire(newNick);
+    if (oldId != INVALID_NAME_ID) {
+        _nickOrder.erase(_names.getFolded(oldId));
+        _nicknames.erase(oldId);
+        _names.release(oldId);
+    }
+    _nicknames.insert(newId, client);
+    _nickOrder[_names.getFolded(newId)] = client;
+    client->setNickId(newId);
+    std::cout << "\033[1;35m[NICKMAP] Added new nickname: " << newNick << " for client on fd " << client->getFd() << "\033[0m" << std::endl;
+
+    // マップ全体の表示は詳細表示（'d'）、整合性チェックは 'c' または IRC_DEBUG_CHECKS=1 で行う
+    if (_debugChecks) {
+        verifyNicknameIndex(std::cout);
+    }
+    _statusSnapshot.nicknames = _nicknames.size();
+    _statusSnapshot.nickChanges++;
+    markStatusDirty();
+}
 
-    // 古いニックネームがある場合はそれを使ってクライアントを特定
-    if (!oldNick.empty()) {
-        std::map<std::string, Client*>::iterator it = _nicknames.find(oldNick);
-        if (it != _nicknames.end()) {
-            client = it->second;
+const NickOrder& Server::getNickOrder() const {
+    return _nickOrder;
+}
 
-            // 古いニックネームをマップから削除
-            std::cout << "\033[1;35m[NICKMAP] Removing old nickname: " << oldNick << "\033[0m" << std::endl;
-            _nicknames.erase(it);
-        } else {
-            std::cout << "\033[1;31m[ERROR] Old nickname not found in map: " << oldNick << "\033[0m" << std::endl;
+void Server::startWhoQuery(const WhoQuery& query) {
+    // 同じクライアントの前のWHOが残っていれば、応答順を保つため後ろに並べる
+    bool queued = false;
+    for (std::deque<WhoQuery>::iterator it = _whoQueue.begin(); it != _whoQueue.end(); ++it) {
+        if (it->getRequester() == query.getRequester()) {
+            queued = true;
+            break;
         }
     }
 
-    // クライアントが特定できなかった場合、FDマップから探す
-    if (!client) {
-        for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
-            if (it->second->getNickname() == newNick) {
-                client = it->second;
-                std::cout << "\033[1;35m[NICKMAP] Client found by new nickname in client map\033[0m" << std::endl;
-                break;
-            }
+    if (queued) {
+        _whoQueue.push_back(query);
+        return;
+    }
+
+    // 最初の一回分はその場で処理し、終わらなければ残りを次のイテレーションへ
+    WhoQuery current = query;
+    size_t budget = WHO_ENTRIES_PER_TURN;
+    if (!current.run(this, budget)) {
+        _whoQueue.push_back(current);
+        std::cout << "\033[1;36m[WHO] Continuing WHO for fd " << current.getFd() << " in later iterations ("
+                  << _whoQueue.size() << " pending)\033[0m" << std::endl;
+    }
+}
+
+void Server::continueWhoQueries() {
+    // 先着順に、1イテレーションあたりWHO_ENTRIES_PER_TURN件まで処理する
+    // 送信キューが溜まっている要求元は書き出しが進むまで保留
+    size_t budget = WHO_ENTRIES_PER_TURN;
+    std::deque<WhoQuery>::iterator it = _whoQueue.begin();
+    while (it != _whoQueue.end() && budget > 0) {
+        Client* requester = it->getRequester();
+        if (requester->getQueuedOutputSize() > WHO_MAX_QUEUED_OUTPUT) {
+            ++it;
+            continue;
         }
+        if (!it->run(this, budget)) {
+            // 予算を使い切った
+            break;
+        }
+        it = _whoQueue.erase(it);
     }
+}
 
-    // クライアントが見つかった場合、新しいニックネームで登録
-    if (client) {
-        _nicknames[newNick] = client;
-        std::cout << "\033[1;35m[NICKMAP] Added new nickname: " << newNick << " for client on fd " << client->getFd() << "\033[0m" << std::endl;
-    } else {
-        std::cout << "\033[1;31m[ERROR] Failed to find client for nickname update\033[0m" << std::endl;
-        return;
+bool Server::hasRunnableWhoQuery() const {
+    for (std::deque<WhoQuery>::const_iterator it = _whoQueue.begin(); it != _whoQueue.end(); ++it) {
+        if (it->getRequester()->getQueuedOutputSize() <= WHO_MAX_QUEUED_OUTPUT) {
+            return true;
+        }
     }
+    return false;
+}
 
-    // デバッグ: 現在のニックネームマップを表示
-    std::cout << "\033[1;35m[NICKMAP] Current map (" << _nicknames.size() << " entries):\033[0m" << std::endl;
-    for (std::map<std::string, Client*>::iterator it = _nicknames.begin(); it != _nicknames.end(); ++it) {
-        std::cout << "  " << it->first << " -> Client on fd " << it->second->getFd()
-                  << " (actual nickname: " << it->second->getNickname() << ")" << std::endl;
+// ニックネーム索引の整合性を検証し、問題の数を返す（通常の処理経路では呼ばない）
+// - 各エントリのクライアントが同じIDを保持し、そのニックネームが同じIDに解決されること
+// - ID付きのクライアントがすべてマップに登録されていること
+int Server::verifyNicknameIndex(std::ostream& out) {
+    int issues = 0;
+
+    for (size_t i = 0; i < _nicknames.capacity(); ++i) {
+        if (!_nicknames.isUsed(i)) {
+            continue;
+        }
+        NameId id = _nicknames.keyAt(i);
+        Client* client = _nicknames.valueAt(i);
+        if (client->getNickId() != id || _names.lookup(client->getNickname()) != id) {
+            out << "\033[1;31m[NICKMAP] Map entry '" << _names.getFolded(id) << "' points to fd " << client->getFd()
+                << " with nickname '" << client->getNickname() << "'\033[0m" << std::endl;
+            issues++;
+        }
     }
 
-    // マップの整合性チェック - 警告表示
-    for (std::map<std::string, Client*>::iterator it = _nicknames.begin(); it != _nicknames.end(); ++it) {
-        if (it->first != it->second->getNickname()) {
-            std::cout << "\033[1;31m[WARNING] Nickname map inconsistency detected: "
-                      << it->first << " != " << it->second->getNickname() << "\033[0m" << std::endl;
+    size_t registered = 0;
+    for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        NameId id = it->second->getNickId();
+        if (id == INVALID_NAME_ID) {
+            continue;
+        }
+        registered++;
+        Client** holder = _nicknames.find(id);
+        if (!holder || *holder != it->second) {
+            out << "\033[1;31m[NICKMAP] Client on fd " << it->first << " ('" << it->second->getNickname()
+                << "') is missing from the nickname map\033[0m" << std::endl;
+            issues++;
         }
     }
 
-    // 状態表示を更新
-    displayServerStatus();
+    if (_nickOrder.size() != _nicknames.size()) {
+        out << "\033[1;31m[NICKMAP] Ordered index has " << _nickOrder.size() << " entries, map has "
+            << _nicknames.size() << "\033[0m" << std::endl;
+        issues++;
+    }
+
+    if (registered != _nicknames.size()) {
+        out << "\033[1;31m[NICKMAP] " << _nicknames.size() << " map entries for " << registered
+            << " registered clients\033[0m" << std::endl;
+        issues++;
+    }
+
+    if (issues == 0) {
+        out << "\033[1;35m[NICKMAP] Index consistent (" << _nicknames.size() << " nicknames, "
+            << _names.size() << " interned names)\033[0m" << std::endl;
+    }
+    return issues;
 }
 
 Channel* Server::getChannel(const std::string& name) {
-    std::map<std::string, Channel*>::iterator it = _channels.find(name);
-    if (it != _channels.end()) {
-        return it->second;
+    Channel* channel = getChannel(_names.lookup(name));
+    if (!channel) {
+        std::cout << "\033[1;33m[CHANNEL] Channel not found: " << name << "\033[0m" << std::endl;
     }
-    std::cout << "\033[1;33m[CHANNEL] Channel not found: " << name << "\033[0m" << std::endl;
-    return NULL;
+    return channel;
+}
+
+Channel* Server::getChannel(NameId id) {
+    if (id == INVALID_NAME_ID) {
+        return NULL;
+    }
+    Channel** channel = _channels.find(id);
+    return channel ? *channel : NULL;
 }
 
 void Server::createChannel(const std::string& name, Client* creator) {
     if (!channelExists(name)) {
-        Channel* channel = new Channel(name, creator);
-        _channels[name] = channel;
+        NameId id = _names.acquire(name);
+        Channel* channel = new (_channelPool.allocate()) Channel(name, id, this, creator);
+        _channels.insert(id, channel);
 
         std::cout << "\033[1;33m[+] Channel created: " << name << " by " << creator->getNickname() << "\033[0m" << std::endl;
 
         // オペレーター設定のログ
         std::cout << "\033[1;33m[CHANNEL] Setting " << creator->getNickname() << " as operator for " << name << "\033[0m" << std::endl;
 
-        displayServerStatus();
+        _statusSnapshot.channels = _channels.size();
+        markStatusDirty();
     } else {
         std::cout << "\033[1;33m[CHANNEL] Cannot create channel " << name << ": already exists\033[0m" << std::endl;
     }
 }
 
-void Server::removeChannel(const std::string& name) {
-    std::map<std::string, Channel*>::iterator it = _channels.find(name);
-    if (it != _channels.end()) {
-        std::cout << "\033[1;33m[-] Channel removed: " << name << "\033[0m" << std::endl;
+// 最後の参加者が抜けた時点でChannel::removeClientから呼ばれる
+void Server::destroyChannel(Channel* channel) {
+    NameId id = channel->getId();
+    if (getChannel(id) != channel) {
+        std::cout << "\033[1;31m[ERROR] Cannot destroy channel " << channel->getName() << ": not registered\033[0m" << std::endl;
+        return;
+    }
 
-        delete it->second;
-        _channels.erase(it);
+    std::cout << "\033[1;33m[-] Channel removed: " << channel->getName() << "\033[0m" << std::endl;
 
-        // 状態表示を更新
-        displayServerStatus();
-    } else {
-        std::cout << "\033[1;33m[CHANNEL] Cannot remove channel " << name << ": not found\033[0m" << std::endl;
-    }
+    _channels.erase(id);
+    _names.release(id);
+    _channelPool.destroy(channel);
+
+    _statusSnapshot.channels = _channels.size();
+    markStatusDirty();
 }
 
 bool Server::channelExists(const std::string& name) const {
-    bool exists = _channels.find(name) != _channels.end();
+    NameId id = _names.lookup(name);
+    bool exists = id != INVALID_NAME_ID && _channels.contains(id);
     std::cout << "\033[1;33m[CHANNEL] Checking if channel '" << name << "' exists: " << (exists ? "YES" : "NO") << "\033[0m" << std::endl;
     return exists;
 }
 
-std::map<std::string, Channel*>& Server::getChannels() {
+ChannelMap& Server::getChannels() {
     return _channels;
 }
 
@@ -431,43 +604,168 @@ void Server::processClientMessage(int fd) {
         return;
     }
 
-    char buffer[BUFFER_SIZE + 1];
-    ssize_t bytesRead;
+    // 受信バッファに直接読み込み、行の実行はスケジューラの順番が来てから行う
+    // 空きを埋め切った場合はまだデータが残っている可能性があるため続けて読む
+    while (true) {
+        char* space;
+        size_t available = client->prepareRecv(space);
+        if (available == 0) {
+            // 受信バッファが満杯（残りはソケットの受信キューに留め、行を実行して空くまでPOLLINを外す）
+            updateReadInterest(client);
+            return;
+        }
 
-    // データを読み込む
-    bytesRead = recv(fd, buffer, BUFFER_SIZE, 0);
+        IoStats::instance().recvCalls++;
+        ssize_t bytesRead = recv(fd, space, available, 0);
 
-    if (bytesRead < 0) {
-        // エラー
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            std::cout << "\033[1;31m[ERROR] recv() failed for fd " << fd << ": " << strerror(errno) << "\033[0m" << std::endl;
-            perror("recv");
+        if (bytesRead < 0) {
+            // エラー
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cout << "\033[1;31m[ERROR] recv() failed for fd " << fd << ": " << strerror(errno) << "\033[0m" << std::endl;
+                perror("recv");
+                removeClient(fd);
+            }
+            return;
+        } else if (bytesRead == 0) {
+            // クライアントが正常に切断（または複数回Ctrl+D）
+            std::cout << "\033[1;31m[CLIENT] Connection closed by client on fd " << fd << "\033[0m" << std::endl;
             removeClient(fd);
+            return;
         }
+
+        std::cout << "\033[1;36m[CLIENT] Received " << bytesRead << " bytes from fd " << fd << "\033[0m" << std::endl;
+        client->commitRecv(bytesRead);
+        scheduleClient(client);
+
+        // 短い読み込みはソケットの受信キューが空になったことを示す（EAGAINのための余分なrecvを省く）
+        if ((size_t)bytesRead < available) {
+            return;
+        }
+    }
+}
+
+void Server::handleClientInput(Client* client, const char* data, size_t length) {
+    // 外部バッファ（io_uring）で受信したデータを受信バッファに移し、行の実行はスケジューラに任せる
+    // 入りきらない分（保留中や順番待ちで行が溜まっている間に届いた分）は取っておく
+    size_t copied = client->hasBacklog() ? 0 : client->appendInput(data, length);
+    if (copied < length) {
+        client->stashInput(data + copied, length - copied);
+    }
+    if (!client->wantsInput()) {
+        updateReadInterest(client);
+    }
+    if (!client->isFloodHeld()) {
+        scheduleClient(client);
+    }
+}
+
+void Server::scheduleClient(Client* client) {
+    if (client->isRunQueued() || client->isFloodHeld()) {
         return;
-    } else if (bytesRead == 0) {
-        // クライアントが正常に切断（または複数回Ctrl+D）
-        std::cout << "\033[1;31m[CLIENT] Connection closed by client on fd " << fd << "\033[0m" << std::endl;
-        removeClient(fd);
+    }
+    client->setRunQueued(true, TimerWheel::nowMs());
+    _runQueue.push_back(client->getFd());
+}
+
+void Server::runScheduledClients() {
+    // 実行待ちのクライアントを順番に回り、1回の順番でK行まで実行する（残りはキューの末尾へ戻し、次のイテレーションで続ける）
+    // イテレーション全体でもコマンドの重みの合計に上限を設け、待機とタイマー処理が遅れないようにする
+    size_t queued = _runQueue.size();
+    if (queued == 0) {
         return;
     }
+    size_t work = 0;
+    unsigned long long now = TimerWheel::nowMs();
+    for (size_t turn = 0; turn < queued && work < (size_t)_workPerIteration; ++turn) {
+        int fd = _runQueue.front();
+        _runQueue.pop_front();
+        // 切断後にfdが再利用された場合は実行待ちになっていない
+        Client* client = getClientByFd(fd);
+        if (!client || !client->isRunQueued()) {
+            continue;
+        }
+        unsigned long long waited = now - client->getRunQueuedMs();
+        if (waited > _schedulerStats.maxWaitMs) {
+            _schedulerStats.maxWaitMs = waited;
+        }
+        if (waited > _schedulerStats.recentMaxWaitMs) {
+            _schedulerStats.recentMaxWaitMs = waited;
+        }
+        client->setRunQueued(false, 0);
+
+        size_t processed = 0;
+        size_t turnWork = 0;
+        bool blocked = !client->wantsInput();
+        client->refillFromBacklog();
+        bool alive = processClientLines(client, _linesPerTurn, _workPerIteration - work, processed, turnWork);
+        work += turnWork;
+        if (!alive) {
+            continue;
+        }
 
-    // 受信したデータをバッファに追加
-    buffer[bytesRead] = '\0';
-    std::cout << "\033[1;36m[CLIENT] Received " << bytesRead << " bytes from fd " << fd << "\033[0m" << std::endl;
-    client->appendToBuffer(buffer);
+        // 実行した分だけ空いた受信バッファに、入りきらなかった分を移す
+        client->refillFromBacklog();
+        // 受信を止めていた（バッファが満杯/取っておいた分が多い）なら、空いた時点で再開
+        if (blocked && client->wantsInput()) {
+            updateReadInterest(client);
+        }
+        // 上限まで実行した（まだ行が残っている可能性がある）か、取っておいた分があれば次の順番へ
+        if (processed == (size_t)_linesPerTurn || work >= (size_t)_workPerIteration || client->hasBacklog()) {
+            scheduleClient(client);
+        }
+    }
 
-    // 完全なメッセージを処理
-    std::vector<std::string> messages = client->getCompleteMessages();
-    std::cout << "\033[1;36m[CLIENT] Extracted " << messages.size() << " complete messages from buffer\033[0m" << std::endl;
+    // 統計は実行待ちがあったイテレーションだけで取る
+    _schedulerStats.iterations++;
+    _schedulerStats.lastWork = work;
+    _schedulerStats.totalWork += work;
+    if (work > _schedulerStats.maxWork) {
+        _schedulerStats.maxWork = work;
+    }
+    if (work >= (size_t)_workPerIteration && !_runQueue.empty()) {
+        _schedulerStats.budgetHits++;
+    }
+    if (queued > _schedulerStats.maxQueued) {
+        _schedulerStats.maxQueued = queued;
+    }
+}
 
-    for (std::vector<std::string>::iterator it = messages.begin(); it != messages.end(); ++it) {
-        executeCommand(client, *it);
+bool Server::processClientLines(Client* client, size_t lineLimit, size_t workLimit, size_t& processed, size_t& work) {
+    int fd = client->getFd();
+    const char* line;
+    size_t length;
+    size_t count = 0;
+
+    // 受信バッファ上で切り出した行を、行数・重みの上限とトークンの範囲で順に実行
+    work = 0;
+    while (count < lineLimit && work < workLimit && client->nextLine(line, length)) {
+        unsigned cost = _commandFactory->getCost(line, length);
+        if (!client->consumeFloodTokens(cost)) {
+            // 足りなければ行を受信バッファに戻し、トークンが貯まるまで保留
+            client->deferLine(line, length);
+            holdClientInput(client, cost);
+            break;
+        }
+        count++;
+        work += cost;
+        // 行は一時領域に移してから実行（QUITでクライアントが削除されてもイテレーション中は参照が残るように）
+        executeCommand(client, _arena.copy(line, length), length);
+
+        // QUITなどでクライアントが削除された場合は残りを破棄
+        if (getClientByFd(fd) != client) {
+            processed = count;
+            return false;
+        }
+    }
+    processed = count;
+    if (count > 0) {
+        std::cout << "\033[1;36m[CLIENT] Processed " << count << " complete messages from buffer\033[0m" << std::endl;
     }
+    return !client->isDisconnectPending();
 }
 
-void Server::executeCommand(Client* client, const std::string& message) {
-    if (message.empty()) {
+void Server::executeCommand(Client* client, const char* message, size_t length) {
+    if (length == 0) {
         std::cout << "\033[1;31m[COMMAND] Empty message received, ignoring\033[0m" << std::endl;
         return;
     }
@@ -478,13 +776,10 @@ void Server::executeCommand(Client* client, const std::string& message) {
     }
     std::cout << ": " << message << "\033[0m" << std::endl;
 
-    // コマンドを作成して実行
-    Command* command = _commandFactory->createCommand(client, message);
-    if (command) {
-        std::cout << "\033[1;36m[COMMAND] Executing command: " << command->getName() << "\033[0m" << std::endl;
-        command->execute();
-        delete command;
-    } else {
+    IoStats::instance().messagesIn++;
+
+    // コマンドテーブルから実行（コマンドはスタック上に生成される）
+    if (!_commandFactory->dispatch(client, message, length)) {
         std::cout << "\033[1;31m[COMMAND] Failed to create command for message: " << message << "\033[0m" << std::endl;
     }
 }
@@ -532,10 +827,118 @@ void Server::displayServerStatus() {
     statusStream << "Hostname: " << _hostname << " | Port: " << _port << " | Uptime: "
               << (time(NULL) - _startTime) << " seconds" << std::endl;
 
+    // I/O統計（システムコール数 / メッセージ数）
+    const IoStats& io = IoStats::instance();
+    statusStream << "I/O: " << (_ioUring ? "io_uring" : _reactor.getBackendName())
+              << " | Syscalls: " << io.totalSyscalls()
+              << " (wait " << io.waitCalls << ", recv " << io.recvCalls << ", send " << io.sendCalls << ")"
+              << " | Messages: " << io.messagesIn << " in / " << io.messagesOut << " out"
+              << " | Syscalls/msg: " << std::fixed << std::setprecision(2) << io.syscallsPerMessage()
+              << " | Lines/write: " << io.linesPerWrite() << std::endl;
+
+    // 接続受け入れ統計
+    updateAcceptRate(time(NULL));
+    long overflows = readListenOverflows();
+    statusStream << "Accept: backlog " << _listenBacklog
+              << " | Total: " << _acceptStats.accepted
+              << " | Rate: " << _acceptStats.perSecond << "/s"
+              << " | Batch cap hits: " << _acceptStats.capHits
+              << " | Listen overflows: ";
+    if (overflows >= 0 && _acceptStats.overflowBase >= 0) {
+        statusStream << (overflows - _acceptStats.overflowBase);
+    } else {
+        statusStream << "n/a";
+    }
+    statusStream << std::endl;
+
+    // キープアライブ統計（RTTは直近のPONGから算出）
+    statusStream << "Keepalive: ping after " << _pingInterval << "s, timeout " << _pingTimeout << "s"
+              << " | Pings: " << _keepaliveStats.pingsSent
+              << " | Pongs: " << _keepaliveStats.pongsMatched
+              << " | Timeouts: " << _keepaliveStats.timeouts;
+    if (!_keepaliveStats.rttSamples.empty()) {
+        statusStream << " | RTT p50/p90/p99: " << getRttPercentile(50) << "/" << getRttPercentile(90)
+                  << "/" << getRttPercentile(99) << " ms";
+    }
+    statusStream << std::endl;
+
+    // 集計（状態変更時に増分更新した値を表示）
+    statusStream << "Users: " << _statusSnapshot.clients
+              << " | Channels: " << _statusSnapshot.channels
+              << " | Nicknames: " << _statusSnapshot.nicknames
+              << " | Connects: " << _statusSnapshot.connects
+              << " | Disconnects: " << _statusSnapshot.disconnects
+              << " | Nick changes: " << _statusSnapshot.nickChanges << std::endl;
+    // プールの使用状況（使用中/確保済みスロット数と最大使用数）と一時領域
+    statusStream << "Pools:";
+    writePoolStats(statusStream, _clientPool.getStats());
+    writePoolStats(statusStream, _channelPool.getStats());
+    writePoolStats(statusStream, SharedMessage::getPoolStats());
+    if (_dccManager) {
+        writePoolStats(statusStream, _dccManager->getPoolStats());
+    }
+    statusStream << " | Arena: " << _arena.getHighWater() << "B peak / "
+              << _arena.getReserved() << "B reserved" << std::endl;
+    // コマンドスケジューラ（1イテレーションで実行したコマンドの重みと、実行待ちになってから順番が来るまでの時間）
+    statusStream << "Scheduler: " << _linesPerTurn << " lines/turn, " << _workPerIteration << " weight/iteration"
+              << " | Work last/avg/max: " << _schedulerStats.lastWork << "/"
+              << (_schedulerStats.iterations ? (double)_schedulerStats.totalWork / _schedulerStats.iterations : 0.0)
+              << "/" << _schedulerStats.maxWork
+              << " | Budget hits: " << _schedulerStats.budgetHits
+              << " | Queue: " << _runQueue.size() << " (max " << _schedulerStats.maxQueued << ")"
+              << " | Max wait: " << _schedulerStats.recentMaxWaitMs << "ms recent, "
+              << _schedulerStats.maxWaitMs << "ms overall" << std::endl;
+    _schedulerStats.recentMaxWaitMs = 0;
+    // フラッド制御（トークンバケットの設定、重みが1でないコマンド、保留の状況）
+    statusStream << "Flood: burst " << _floodBurst << ", refill " << _floodRate << "/s"
+              << " | Weights: " << _commandFactory->describeWeights()
+              << " | Held: " << _floodStats.heldClients
+              << " | Holds: " << _floodStats.holds
+              << " | Deferred lines: " << _floodStats.deferredLines << std::endl;
+    // 送信キューの上限と低速な接続の切断数（上限超過 + ウォーターマーク超過の継続）
+    statusStream << "SendQ:";
+    for (int i = 0; i < SENDQ_CLASS_COUNT; ++i) {
+        const SendQClass& sendQ = _sendQClasses[i];
+        statusStream << (i > 0 ? " |" : "") << " " << sendQ.name << " " << sendQ.limit / 1024 << "KB"
+                  << " (dropped " << sendQ.exceeded << " + " << sendQ.stalled << " stalled)";
+    }
+    statusStream << " | Stall after " << _sendQStallSeconds << "s" << std::endl;
+    // メモリ予算（サブシステム別の使用量と受信停止/切断の状況）
+    MemoryUsage memory = getMemoryUsage();
+    statusStream << "Memory: " << memory.total() / 1024 << "KB / " << _memoryStats.budget / 1024 << "KB"
+              << " (peak " << _memoryStats.peak / 1024 << "KB)"
+              << " | clients " << memory.clients / 1024 << "KB, channels " << memory.channels / 1024
+              << "KB, messages " << memory.messages / 1024 << "KB, dcc " << memory.transfers / 1024
+              << "KB, io_uring " << memory.ioUring / 1024 << "KB, arena " << memory.arena / 1024 << "KB"
+              << " | Paused: " << _memoryStats.pausedClients << (_memoryStats.underPressure ? " (under pressure)" : "")
+              << " | Pauses: " << _memoryStats.pauses
+              << " | Shed: " << _memoryStats.sheds << std::endl;
+    statusStream << "Status: every " << _statusInterval << "ms at most"
+              << " | Changes: " << _statusSnapshot.version
+              << " | Renders: " << (_statusSnapshot.renders + 1) << std::endl;
+
+    showRecentConnections(statusStream);
+
+    if (_detailedView) {
+        displayDetailedStatus(statusStream);
+    } else if (_consoleWatched) {
+        statusStream << "(press 'd' + Enter for users, channels and nickname map)" << std::endl;
+    }
+
+    // 区切り線
+    statusStream << "\033[1;44m";
+    for (int i = 0; i < 50; i++) statusStream << "=";
+    statusStream << "\033[0m" << std::endl;
+
+    // 一度にステータスを表示（画面のちらつきを防止）
+    std::cout << statusStream.str() << std::flush;
+}
+
+void Server::displayDetailedStatus(std::ostream& out) {
     // ユーザー情報
-    statusStream << "\033[1;36m=== Connected Users (" << _clients.size() << ") ===\033[0m" << std::endl;
+    out << "\033[1;36m=== Connected Users (" << _clients.size() << ") ===\033[0m" << std::endl;
     if (_clients.empty()) {
-        statusStream << "No users connected" << std::endl;
+        out << "No users connected" << std::endl;
     } else {
         // 最大表示人数
         int maxUsers = 10;
@@ -545,143 +948,248 @@ void Server::displayServerStatus() {
              it != _clients.end() && count < maxUsers; ++it, ++count) {
             Client* client = it->second;
 
-            statusStream << "• " << client->getFd() << ": ";
+            out << "• " << client->getFd() << ": ";
             // ニックネーム情報を追加
             if (!client->getNickname().empty()) {
-                statusStream << client->getNickname();
+                out << client->getNickname();
             } else {
-                statusStream << "(no nickname)";
+                out << "(no nickname)";
             }
             if (!client->getUsername().empty()) {
-                statusStream << " [" << client->getUsername() << "]";
+                out << " [" << client->getUsername() << "]";
             } else {
-                statusStream << " [no username]";
+                out << " [no username]";
             }
 
             // ステータス表示
             switch (client->getStatus()) {
-                case CONNECTING: statusStream << " [connecting]"; break;
-                case REGISTERING: statusStream << " [registering]"; break;
-                case REGISTERED: statusStream << " [registered]"; break;
-                default: statusStream << " [unknown]";
+                case CONNECTING: out << " [connecting]"; break;
+                case REGISTERING: out << " [registering]"; break;
+                case REGISTERED: out << " [registered]"; break;
+                default: out << " [unknown]";
             }
 
             // チャンネル数
             if (!client->getChannels().empty()) {
-                statusStream << " in " << client->getChannels().size() << " channels";
+                out << " in " << client->getChannels().size() << " channels";
+            }
+
+            // 直近のRTT
+            if (client->getLastRtt() >= 0) {
+                out << " rtt " << client->getLastRtt() << "ms";
+            }
+
+            // メモリ使用量（未送信バイト数を含む）
+            ClientMemory memory = client->getMemoryUsage();
+            out << " mem " << memory.total() << "B (sendq " << memory.sendQueue
+                << "B, recv " << memory.recvPending << "B)";
+            if (client->isReadPaused()) {
+                out << " \033[1;33m[paused]\033[0m";
             }
 
-            statusStream << std::endl;
+            out << std::endl;
         }
 
         if (_clients.size() > (size_t)maxUsers) {
-            statusStream << "... and " << (_clients.size() - maxUsers) << " more users" << std::endl;
+            out << "... and " << (_clients.size() - maxUsers) << " more users" << std::endl;
         }
     }
 
     // チャンネル情報
-    statusStream << "\033[1;33m=== Channels (" << _channels.size() << ") ===\033[0m" << std::endl;
+    out << "\033[1;33m=== Channels (" << _channels.size() << ") ===\033[0m" << std::endl;
     if (_channels.empty()) {
-        statusStream << "No channels" << std::endl;
+        out << "No channels" << std::endl;
     } else {
         // 最大表示数
         int maxChannels = 10;
         int count = 0;
 
-        for (std::map<std::string, Channel*>::iterator it = _channels.begin();
-             it != _channels.end() && count < maxChannels; ++it, ++count) {
-            Channel* channel = it->second;
+        for (size_t i = 0; i < _channels.capacity() && count < maxChannels; ++i) {
+            if (!_channels.isUsed(i)) {
+                continue;
+            }
+            Channel* channel = _channels.valueAt(i);
+            count++;
 
             // クライアント数をリアルタイムに取得
             size_t clientCount = channel->getClientCount();
 
-            statusStream << "• " << channel->getName() << " (" << clientCount << " users)";
+            out << "• " << channel->getName() << " (" << clientCount << " users)";
 
             // オペレーター表示（最大3人）
-            std::vector<Client*> clients = channel->getClients();
+            const MemberList& members = channel->getMembers();
             std::vector<std::string> operators;
 
-            for (std::vector<Client*>::iterator cit = clients.begin(); cit != clients.end(); ++cit) {
-                if (channel->isOperator((*cit)->getNickname())) {
-                    operators.push_back((*cit)->getNickname());
+            for (MemberList::const_iterator mit = members.begin(); mit != members.end(); ++mit) {
+                if (mit->modes & MEMBER_OPERATOR) {
+                    operators.push_back(mit->client->getNickname());
                 }
             }
 
             if (!operators.empty()) {
-                statusStream << " [ops: ";
+                out << " [ops: ";
                 for (size_t i = 0; i < operators.size() && i < 3; ++i) {
-                    if (i > 0) statusStream << ", ";
-                    statusStream << operators[i];
+                    if (i > 0) out << ", ";
+                    out << operators[i];
                 }
 
                 if (operators.size() > 3) {
-                    statusStream << ", +" << (operators.size() - 3) << " more";
+                    out << ", +" << (operators.size() - 3) << " more";
                 }
 
-                statusStream << "]";
+                out << "]";
             }
 
-            statusStream << std::endl;
+            out << std::endl;
         }
 
         if (_channels.size() > (size_t)maxChannels) {
-            statusStream << "... and " << (_channels.size() - maxChannels) << " more channels" << std::endl;
+            out << "... and " << (_channels.size() - maxChannels) << " more channels" << std::endl;
         }
     }
 
-    // ニックネームマップ情報（問題があれば表示）
-    int inconsistencies = 0;
-    for (std::map<std::string, Client*>::iterator it = _nicknames.begin(); it != _nicknames.end(); ++it) {
-        if (it->first != it->second->getNickname()) {
-            inconsistencies++;
-        }
-    }
-
-    if (inconsistencies > 0) {
-        statusStream << "\033[1;31m=== Nickname Map Issues (" << inconsistencies << ") ===\033[0m" << std::endl;
-
-        for (std::map<std::string, Client*>::iterator it = _nicknames.begin(); it != _nicknames.end(); ++it) {
-            if (it->first != it->second->getNickname()) {
-                statusStream << "• Map entry '" << it->first << "' points to client with nickname '"
-                          << it->second->getNickname() << "'" << std::endl;
-            }
-        }
-    }
-
-    // ニックネームマップ情報（常時表示）
-    statusStream << "\033[1;35m=== Nickname Map (" << _nicknames.size() << ") ===\033[0m" << std::endl;
+    // ニックネームマップ情報
+    out << "\033[1;35m=== Nickname Map (" << _nicknames.size() << ") ===\033[0m" << std::endl;
     if (_nicknames.empty()) {
-        statusStream << "No registered nicknames" << std::endl;
+        out << "No registered nicknames" << std::endl;
     } else {
         // 最大表示数
         int maxNicks = 10;
         int count = 0;
 
-        for (std::map<std::string, Client*>::iterator it = _nicknames.begin();
-             it != _nicknames.end() && count < maxNicks; ++it, ++count) {
+        for (size_t i = 0; i < _nicknames.capacity() && count < maxNicks; ++i) {
+            if (!_nicknames.isUsed(i)) {
+                continue;
+            }
+            Client* client = _nicknames.valueAt(i);
+            count++;
 
-            statusStream << "• " << it->first << " -> fd:" << it->second->getFd();
+            out << "• " << _names.getFolded(_nicknames.keyAt(i)) << " -> fd:" << client->getFd();
 
             // 不整合があれば強調表示
-            if (it->first != it->second->getNickname()) {
-                statusStream << " \033[1;31m[MISMATCH: actual=" << it->second->getNickname() << "]\033[0m";
+            if (client->getNickId() != _nicknames.keyAt(i)) {
+                out << " \033[1;31m[MISMATCH: actual=" << client->getNickname() << "]\033[0m";
             }
 
-            statusStream << std::endl;
+            out << std::endl;
         }
 
         if (_nicknames.size() > (size_t)maxNicks) {
-            statusStream << "... and " << (_nicknames.size() - maxNicks) << " more nicknames" << std::endl;
+            out << "... and " << (_nicknames.size() - maxNicks) << " more nicknames" << std::endl;
         }
     }
+}
 
-    // 区切り線
-    statusStream << "\033[1;44m";
-    for (int i = 0; i < 50; i++) statusStream << "=";
-    statusStream << "\033[0m" << std::endl;
+void Server::showRecentConnections(std::ostream& out) {
+    if (_connectionLog.empty()) {
+        return;
+    }
 
-    // 一度にステータスを表示（画面のちらつきを防止）
-    std::cout << statusStream.str();
+    out << "\033[1;32m=== Recent Connections ===\033[0m" << std::endl;
+    for (std::deque<ConnectionLogEntry>::const_iterator it = _connectionLog.begin(); it != _connectionLog.end(); ++it) {
+        char timeBuffer[16];
+        strftime(timeBuffer, sizeof(timeBuffer), "%H:%M:%S", localtime(&it->time));
+        out << it->color << "• " << timeBuffer << " " << it->text << "\033[0m" << std::endl;
+    }
+}
+
+void Server::addConnectionLog(const std::string& log, const std::string& color) {
+    // 表示しない場合は保持しない
+    if (_headless) {
+        return;
+    }
+
+    ConnectionLogEntry entry;
+    entry.time = time(NULL);
+    entry.text = log;
+    entry.color = color;
+    _connectionLog.push_back(entry);
+    if (_connectionLog.size() > CONNECTION_LOG_SIZE) {
+        _connectionLog.pop_front();
+    }
+}
+
+void Server::markStatusDirty() {
+    _statusSnapshot.version++;
+    if (_headless || _statusTimer.isScheduled()) {
+        return;
+    }
+
+    // 前回の表示から間隔が空いていれば次のtickで、そうでなければ残り時間後に表示
+    unsigned long long now = TimerWheel::nowMs();
+    unsigned long long elapsed = now - _lastStatusRender;
+    unsigned long delay = 0;
+    if (elapsed < (unsigned long long)_statusInterval) {
+        delay = (unsigned long)(_statusInterval - elapsed);
+    }
+    _timers.schedule(_statusTimer, delay);
+}
+
+void Server::writePoolStats(std::ostream& out, const PoolStats& stats) {
+    out << " " << stats.name << " " << stats.inUse << "/" << stats.capacity
+        << " (peak " << stats.highWater << ", " << stats.objectSize << "B each)";
+}
+
+void Server::renderStatus() {
+    if (_headless) {
+        return;
+    }
+    // 初回以外は変更がなければ表示しない
+    if (_statusSnapshot.renders > 0 && _statusSnapshot.renderedVersion == _statusSnapshot.version) {
+        return;
+    }
+
+    displayServerStatus();
+    _statusSnapshot.renderedVersion = _statusSnapshot.version;
+    _statusSnapshot.renders++;
+    _lastStatusRender = TimerWheel::nowMs();
+}
+
+void Server::toggleDetailedView() {
+    _detailedView = !_detailedView;
+    std::cout << "\033[1;36m[STATUS] Detailed view " << (_detailedView ? "enabled" : "disabled") << "\033[0m" << std::endl;
+    markStatusDirty();
+}
+
+void Server::checkInput() {
+    char buffer[64];
+    ssize_t bytesRead = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (bytesRead <= 0) {
+        // EOF（端末が閉じられた）の場合は監視をやめる
+        if (bytesRead == 0 || (errno != EAGAIN && errno != EINTR)) {
+            _reactor.remove(STDIN_FILENO);
+            _consoleWatched = false;
+        }
+        return;
+    }
+
+    for (ssize_t i = 0; i < bytesRead; ++i) {
+        switch (tolower((unsigned char)buffer[i])) {
+            case 'd':
+                toggleDetailedView();
+                break;
+            case 's':
+                // 間隔を待たずに再表示
+                _statusTimer.cancel();
+                _statusSnapshot.version++;
+                renderStatus();
+                break;
+            case 'c':
+                // 索引の整合性チェック（必要な時だけ実行）
+                verifyNicknameIndex(std::cout);
+                break;
+            case 'h':
+            case '?':
+                std::cout << "\033[1;36m[STATUS] Commands: d = toggle detailed view, s = refresh now, c = check nickname index, h = help\033[0m" << std::endl;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+const StatusSnapshot& Server::getStatusSnapshot() const {
+    return _statusSnapshot;
 }
 
 void Server::initializeSocket() {
@@ -710,21 +1218,9 @@ void Server::initializeSocket() {
         exit(EXIT_FAILURE);
     }
 
-    // // SO_REUSEPORTオプションの設定（可能な場合）
-    // #ifdef SO_REUSEPORT
-    // if (setsockopt(_serverSocket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
-    //     std::cout << "\033[1;33m[WARNING] setsockopt(SO_REUSEPORT) failed: " << strerror(errno) << "\033[0m" << std::endl;
-    //     // 致命的でないためcontinue
-    // }
-    // #endif
-
-    // // TCP_NODELAYオプションの設定（パフォーマンス向上）
-    // #ifdef TCP_NODELAY
-    // if (setsockopt(_serverSocket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
-    //     std::cout << "\033[1;33m[WARNING] setsockopt(TCP_NODELAY) failed: " << strerror(errno) << "\033[0m" << std::endl;
-    //     // 致命的でないためcontinue
-    // }
-    // #endif
+    // SO_REUSEPORTは設定しない
+    // 状態（_clients / _channels / _nicknames）は単一のイベントループが所有しており、
+    // 同じポートで複数プロセスを起動すると接続が互いに状態を共有しないサーバーへ振り分けられるため
 
     // ノンブロッキングに設定
     setNonBlocking(_serverSocket);
@@ -743,14 +1239,20 @@ void Server::initializeSocket() {
         exit(EXIT_FAILURE);
     }
 
-    // リスニングの開始
-    if (listen(_serverSocket, 10) < 0) {
+    // リスニングの開始（再接続が集中してもSYNを落とさないようバックログを確保）
+    if (listen(_serverSocket, _listenBacklog) < 0) {
         std::cout << "\033[1;31m[ERROR] listen() failed: " << strerror(errno) << "\033[0m" << std::endl;
         perror("listen");
         close(_serverSocket);
         exit(EXIT_FAILURE);
     }
 
+    // イベント多重化の初期化とリスニングソケットの登録
+    if (!_reactor.init() || !_reactor.add(_serverSocket, FD_LISTENER, POLLIN)) {
+        close(_serverSocket);
+        exit(EXIT_FAILURE);
+    }
+
     std::cout << "\033[1;32m[SERVER] Successfully initialized socket on port " << _port << "\033[0m" << std::endl;
 }
 
@@ -774,21 +1276,49 @@ void Server::setNonBlocking(int fd) {
 }
 
 void Server::handleNewConnection() {
+    // accept待ちキューをEAGAINまで取り出す（1イテレーションあたりの上限付き）
+    int count = 0;
+    while (count < MAX_ACCEPTS_PER_ITERATION && acceptConnection()) {
+        count++;
+    }
+    if (count == MAX_ACCEPTS_PER_ITERATION) {
+        // 残りは次のイテレーションで処理（レベルトリガーのため再通知される）
+        _acceptStats.capHits++;
+    }
+    if (count > 0) {
+        std::cout << "\033[1;32m[SERVER] Accepted " << count << " connection(s) in this iteration\033[0m" << std::endl;
+    }
+}
+
+bool Server::acceptConnection() {
     struct sockaddr_in clientAddr;
     socklen_t clientAddrLen = sizeof(clientAddr);
     int clientSocket;
 
-    // 新しい接続を受け入れる
+    // 新しい接続を受け入れる（Linuxではノンブロッキング/CLOEXECを同時に設定）
+#ifdef __linux__
+    clientSocket = accept4(_serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
     clientSocket = accept(_serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
+#endif
 
     if (clientSocket < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+            // 受け入れ前に切断された接続は読み飛ばす
+            return true;
+        }
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
             std::cout << "\033[1;31m[ERROR] accept() failed: " << strerror(errno) << "\033[0m" << std::endl;
             perror("accept");
         }
-        return;
+        return false;
     }
 
+#ifndef __linux__
+    setNonBlocking(clientSocket);
+    fcntl(clientSocket, F_SETFD, FD_CLOEXEC);
+#endif
+
     // クライアントのホスト名を取得
     char hostBuffer[NI_MAXHOST];
     if (getnameinfo((struct sockaddr*)&clientAddr, clientAddrLen, hostBuffer, sizeof(hostBuffer), NULL, 0, NI_NUMERICHOST) != 0) {
@@ -801,142 +1331,590 @@ void Server::handleNewConnection() {
 
     // クライアントを追加
     addClient(clientSocket, hostBuffer);
+
+    _acceptStats.accepted++;
+    _acceptStats.windowCount++;
+    updateAcceptRate(time(NULL));
+    return true;
 }
 
-void Server::handleClientData(size_t i) {
-    int clientFd = _pollfds[i].fd;
+void Server::updateAcceptRate(time_t now) {
+    // 1秒以上経過したら区間のレートを確定
+    time_t elapsed = now - _acceptStats.windowStart;
+    if (elapsed >= 1) {
+        _acceptStats.perSecond = (double)_acceptStats.windowCount / elapsed;
+        _acceptStats.windowCount = 0;
+        _acceptStats.windowStart = now;
+    }
+}
 
-    std::cout << "\033[1;36m[SERVER] Activity detected on fd " << clientFd << "\033[0m" << std::endl;
+long Server::readListenOverflows() const {
+    // acceptキューの溢れ回数（システム全体のTcpExt:ListenOverflows）
+#ifdef __linux__
+    std::ifstream netstat("/proc/net/netstat");
+    std::string header;
+    std::string values;
+    while (std::getline(netstat, header) && std::getline(netstat, values)) {
+        if (header.compare(0, 7, "TcpExt:") != 0) {
+            continue;
+        }
+        std::istringstream names(header);
+        std::istringstream numbers(values);
+        std::string name;
+        std::string number;
+        while (names >> name && numbers >> number) {
+            if (name == "ListenOverflows") {
+                return strtol(number.c_str(), NULL, 10);
+            }
+        }
+    }
+#endif
+    return -1;
+}
+
+int Server::waitForEvents(int timeoutMs) {
+    // io_uringでは送信の投入と待機が1回のio_uring_enterで行われる
+    if (_ioUring) {
+        int result = _ioUring->wait(timeoutMs);
+        if (result < 0) {
+            return -1;
+        }
+        dispatchIoUringEvents();
+        return result;
+    }
 
-    processClientMessage(clientFd);
+    // イベントを待機（登録済みfdのみを監視）
+    int result = _reactor.wait(timeoutMs);
+    if (result < 0) {
+        return -1;
+    }
+    dispatchReadyEvents();
+    return result;
 }
 
-void Server::checkDisconnectedClients() {
-    // タイムアウトしたクライアントを削除
-    // （この実装では行わない）
+void Server::dispatchReadyEvents() {
+    // 準備完了したfdのみをハンドラテーブルに従って処理
+    const std::vector<ReadyEvent>& events = _reactor.getReadyEvents();
+    for (size_t i = 0; i < events.size(); i++) {
+        const ReadyEvent& event = events[i];
+
+        // 同じイテレーション内で削除されたfdはスキップ
+        const FdHandler* handler = _reactor.getHandler(event.fd);
+        if (!handler) {
+            continue;
+        }
+
+        switch (handler->kind) {
+            case FD_LISTENER:
+                // 新しい接続を処理
+                if (event.readable) {
+                    handleNewConnection();
+                }
+                break;
+
+            case FD_CLIENT:
+                // クライアントからのデータを処理
+                if (event.readable) {
+                    handleClientData(event.fd);
+                }
+                // 送信キューを書き出す（読み込みで削除済みでなければ）
+                if (event.writable && _reactor.getHandler(event.fd)) {
+                    handleClientWrite(event.fd);
+                }
+                // エラーや切断を処理（読み込みで削除済みでなければ）
+                if (event.error && _reactor.getHandler(event.fd)) {
+                    removeClient(event.fd);
+                }
+                break;
+
+            case FD_DCC_LISTEN:
+            case FD_DCC_DATA:
+                // DCC転送ソケットのイベントを処理
+                handleDCCEvent(event);
+                break;
+
+            case FD_CONSOLE:
+                // ステータス表示の操作
+                checkInput();
+                break;
+
+            default:
+                break;
+        }
+    }
 }
 
-void Server::checkAndRemoveEmptyChannels() {
-    std::vector<std::string> channelsToRemove;
+void Server::dispatchIoUringEvents() {
+    const std::vector<UringEvent>& events = _ioUring->getEvents();
+    for (size_t i = 0; i < events.size(); i++) {
+        const UringEvent& event = events[i];
 
-    // 最初のパス：削除するチャンネルを特定する
-    for (std::map<std::string, Channel*>::iterator it = _channels.begin(); it != _channels.end(); ++it) {
-        Channel* channel = it->second;
-        std::vector<Client*> clients = channel->getClients();
+        switch (event.type) {
+            case URING_REACTOR:
+                // リスニングソケット/DCCソケットはReactorで処理
+                if (_reactor.wait(0) > 0) {
+                    dispatchReadyEvents();
+                }
+                break;
 
-        // クライアント数が0の場合は削除対象
-        if (clients.empty()) {
-            channelsToRemove.push_back(it->first);
-            std::cout << "\033[1;33m[CLEANUP] Marking empty channel for removal: " << it->first << "\033[0m" << std::endl;
-        } else {
-            // クライアントが実際に有効かどうかをチェック
-            bool validClientsExist = false;
-
-            for (std::vector<Client*>::iterator cit = clients.begin(); cit != clients.end(); ++cit) {
-                // クライアントが有効かどうかをチェック（_clientsマップに存在するか）
-                if (*cit != NULL && getClientByFd((*cit)->getFd()) != NULL) {
-                    validClientsExist = true;
-                    break;
+            case URING_RECV: {
+                Client* client = getClientByFd(event.fd);
+                if (client) {
+                    if (event.len == 0) {
+                        std::cout << "\033[1;31m[CLIENT] Connection closed by client on fd " << event.fd << "\033[0m" << std::endl;
+                        removeClient(event.fd);
+                    } else {
+                        std::cout << "\033[1;36m[CLIENT] Received " << event.len << " bytes from fd " << event.fd << "\033[0m" << std::endl;
+                        handleClientInput(client, event.data, event.len);
+                    }
                 }
+                // 受信バッファをリングに返却
+                _ioUring->recycle(event);
+                break;
             }
 
-            // 有効なクライアントが一人もいない場合も削除対象
-            if (!validClientsExist) {
-                channelsToRemove.push_back(it->first);
-                std::cout << "\033[1;33m[CLEANUP] Marking channel with invalid clients for removal: " << it->first
-                         << " (client count: " << clients.size() << ")\033[0m" << std::endl;
-            }
+            case URING_CLOSED:
+                if (getClientByFd(event.fd)) {
+                    std::cout << "\033[1;31m[ERROR] I/O failed for fd " << event.fd << ": " << strerror(event.error) << "\033[0m" << std::endl;
+                    removeClient(event.fd);
+                }
+                break;
         }
     }
+}
 
-    // 第二パス：特定したチャンネルを安全に削除する
-    for (std::vector<std::string>::iterator it = channelsToRemove.begin(); it != channelsToRemove.end(); ++it) {
-        std::string channelName = *it;
-        std::cout << "\033[1;33m[CLEANUP] Removing empty channel: " << channelName << "\033[0m" << std::endl;
+void Server::handleClientData(int fd) {
+    std::cout << "\033[1;36m[SERVER] Activity detected on fd " << fd << "\033[0m" << std::endl;
 
-        // マップ内にまだチャンネルが存在するかどうかをチェック
-        std::map<std::string, Channel*>::iterator channelIt = _channels.find(channelName);
-        if (channelIt != _channels.end()) {
-            Channel* channel = channelIt->second;
+    processClientMessage(fd);
+}
 
-            // マップから先に削除し、それからチャンネルオブジェクトを削除
-            _channels.erase(channelIt);
+void Server::handleClientWrite(int fd) {
+    Client* client = getClientByFd(fd);
+    if (!client) {
+        return;
+    }
+    if (!client->flushOutput()) {
+        removeClient(fd);
+        return;
+    }
+    updateWriteInterest(client);
+    checkSendQ(client);
+}
 
-            std::cout << "\033[1;33m[-] Channel removed: " << channelName << "\033[0m" << std::endl;
-            delete channel;
+void Server::requestFlush(Client* client) {
+    _flushList.push_back(client->getFd());
+}
+
+void Server::requestDisconnect(Client* client) {
+    _disconnectList.push_back(client->getFd());
+}
+
+void Server::flushPendingOutput() {
+    // 送信中に追加される分と分けるため一時領域に写す（_flushListは容量を保ったまま空にする）
+    size_t count = _flushList.size();
+    if (count == 0) {
+        return;
+    }
+    int* flushList = static_cast<int*>(_arena.allocate(count * sizeof(int)));
+    std::copy(_flushList.begin(), _flushList.end(), flushList);
+    _flushList.clear();
+    for (size_t i = 0; i < count; ++i) {
+        Client* client = getClientByFd(flushList[i]);
+        if (!client) {
+            continue;
         }
+        client->setFlushScheduled(false);
+
+        // POLLOUT待ちの間は書き込み可能通知で送信する
+        const FdHandler* handler = _reactor.getHandler(flushList[i]);
+        if (handler && (handler->events & POLLOUT)) {
+            continue;
+        }
+        if (client->flushOutput()) {
+            updateWriteInterest(client);
+            checkSendQ(client);
+        }
+    }
+}
+
+void Server::updateWriteInterest(Client* client) {
+    // 送信キューにデータがある間だけPOLLOUTを監視（受信停止/保留中はPOLLINを外す）
+    short events = client->wantsInput() ? POLLIN : 0;
+    if (client->hasQueuedOutput()) {
+        events |= POLLOUT;
     }
+    _reactor.modify(client->getFd(), events);
 }
 
-void Server::updatePollFds() {
-    // 前回の poll FDs の数を保存
-    static size_t lastPollFDCount = 0;
+void Server::updateReadInterest(Client* client) {
+    // 受信停止/保留の状態をI/Oエンジンに反映
+    if (_ioUring) {
+        if (client->wantsInput()) {
+            _ioUring->resumeRecv(client->getFd());
+        } else {
+            _ioUring->pauseRecv(client->getFd());
+        }
+    } else {
+        updateWriteInterest(client);
+    }
+}
 
-    _pollfds.clear();
+void Server::handleDCCEvent(const ReadyEvent& event) {
+    if (!_dccManager) {
+        _reactor.remove(event.fd);
+        return;
+    }
 
-    // サーバーソケットを追加
-    struct pollfd serverPollFd;
-    serverPollFd.fd = _serverSocket;
-    serverPollFd.events = POLLIN;
-    serverPollFd.revents = 0;
-    _pollfds.push_back(serverPollFd);
+    if (event.readable || event.writable || event.error) {
+        _dccManager->handleTransferSocket(event.fd);
+    }
 
-    // クライアントソケットを追加
-    for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
-        struct pollfd clientPollFd;
-        clientPollFd.fd = it->first;
-        clientPollFd.events = POLLIN;
-        clientPollFd.revents = 0;
-        _pollfds.push_back(clientPollFd);
+    // エラー後も登録が残っている場合は監視を解除（HUPの連続通知を防ぐ）
+    if (event.error && _reactor.getHandler(event.fd)) {
+        std::cout << "[DCC] Socket error/disconnect on fd: " << event.fd << std::endl;
+        _dccManager->removeTransferSocket(event.fd);
     }
-    
-    // DCC転送ソケットを追加
-    if (_dccManager) {
-        std::vector<DCCTransfer*> transfers = _dccManager->getActiveTransfers();
-        for (size_t i = 0; i < transfers.size(); ++i) {
-            DCCTransfer* transfer = transfers[i];
-            
-            // リスニングソケットがある場合（送信側のPENDING状態）
-            if (transfer->getListenSocket() >= 0) {
-                struct pollfd dccListenFd;
-                dccListenFd.fd = transfer->getListenSocket();
-                dccListenFd.events = POLLIN;
-                dccListenFd.revents = 0;
-                _pollfds.push_back(dccListenFd);
+}
+
+void Server::checkDisconnectedClients() {
+    // 送信エラーやタイムアウトで切断予定になったクライアントを削除
+    // （コマンド実行中に削除しないよう、ループ末尾でまとめて行う）
+    // 削除中のQUIT通知で新たに切断予定になる分もあるため、リストが空になるまで繰り返す
+    while (!_disconnectList.empty()) {
+        size_t count = _disconnectList.size();
+        int* clientsToRemove = static_cast<int*>(_arena.allocate(count * sizeof(int)));
+        std::copy(_disconnectList.begin(), _disconnectList.end(), clientsToRemove);
+        _disconnectList.clear();
+        for (size_t i = 0; i < count; ++i) {
+            // 別の経路で削除済み（fdが再利用された場合を含む）なら切断予定になっていない
+            Client* client = getClientByFd(clientsToRemove[i]);
+            if (client && client->isDisconnectPending()) {
+                removeClient(clientsToRemove[i]);
             }
-            
-            // データソケットがある場合（アクティブな転送）
-            if (transfer->getDataSocket() >= 0) {
-                struct pollfd dccDataFd;
-                dccDataFd.fd = transfer->getDataSocket();
-                dccDataFd.events = POLLIN | POLLOUT;
-                dccDataFd.revents = 0;
-                _pollfds.push_back(dccDataFd);
+        }
+    }
+}
+
+BotManager* Server::getBotManager() {
+    return _botManager;
+}
+
+IoUring* Server::getIoUring() {
+    return _ioUring;
+}
+
+TimerWheel& Server::getTimers() {
+    return _timers;
+}
+
+void Server::onTimer(Timer& timer) {
+    // 予約されたステータス再表示
+    if (&timer == &_statusTimer) {
+        renderStatus();
+    }
+}
+
+int Server::getPingInterval() const {
+    return _pingInterval;
+}
+
+int Server::getPingTimeout() const {
+    return _pingTimeout;
+}
+
+void Server::recordPingSent() {
+    _keepaliveStats.pingsSent++;
+}
+
+void Server::recordPingRtt(long rttMs) {
+    _keepaliveStats.pongsMatched++;
+    if (_keepaliveStats.rttSamples.size() < RTT_SAMPLE_COUNT) {
+        _keepaliveStats.rttSamples.push_back(rttMs);
+    } else {
+        _keepaliveStats.rttSamples[_keepaliveStats.rttNext] = rttMs;
+    }
+    _keepaliveStats.rttNext = (_keepaliveStats.rttNext + 1) % RTT_SAMPLE_COUNT;
+}
+
+void Server::recordPingTimeout() {
+    _keepaliveStats.timeouts++;
+}
+
+long Server::getRttPercentile(double percentile) const {
+    // 直近のサンプルから最近傍順位法で算出（サンプルなしは-1）
+    if (_keepaliveStats.rttSamples.empty()) {
+        return -1;
+    }
+    std::vector<long> sorted(_keepaliveStats.rttSamples);
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = (size_t)(percentile / 100.0 * sorted.size() + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > sorted.size()) {
+        rank = sorted.size();
+    }
+    return sorted[rank - 1];
+}
+
+SendQClassId Server::getSendQClass(const Client* client) const {
+    if (client->isOperator()) {
+        return SENDQ_OPERATOR;
+    }
+    if (client->isRegistered()) {
+        return SENDQ_USER;
+    }
+    return SENDQ_UNREGISTERED;
+}
+
+void Server::checkSendQ(Client* client) {
+    // 送信キューへの追加と書き出し、停滞判定タイマーの満了で呼ばれる（上限とウォーターマークの比較だけ）
+    if (client->isSendQExceeded()) {
+        return;
+    }
+    SendQClass& sendQ = _sendQClasses[getSendQClass(client)];
+    size_t queued = client->getQueuedOutputSize();
+
+    if (queued > sendQ.limit) {
+        std::cout << "\033[1;31m[SENDQ] fd " << client->getFd() << " (" << sendQ.name << ") queued "
+                  << queued << " bytes, over the " << sendQ.limit << " byte limit\033[0m" << std::endl;
+        sendQ.exceeded++;
+        client->exceedSendQ();
+        markStatusDirty();
+        return;
+    }
+
+    if (queued <= sendQ.watermark) {
+        client->setSendQAboveSince(0);
+        return;
+    }
+    time_t now = time(NULL);
+    if (client->getSendQAboveSince() == 0) {
+        // 以降キューに出し入れがなくても、期限にタイマーで再確認する
+        client->setSendQAboveSince(now);
+        client->scheduleSendQCheck(_sendQStallSeconds * 1000UL);
+    } else if (now - client->getSendQAboveSince() >= _sendQStallSeconds) {
+        std::cout << "\033[1;31m[SENDQ] fd " << client->getFd() << " (" << sendQ.name << ") stayed above "
+                  << sendQ.watermark << " queued bytes for " << _sendQStallSeconds << "s\033[0m" << std::endl;
+        sendQ.stalled++;
+        client->exceedSendQ();
+        markStatusDirty();
+    } else if (!client->isSendQCheckScheduled()) {
+        // 秒単位の時刻との差でタイマーが早く満了した場合は残りの時間で再設定
+        client->scheduleSendQCheck((_sendQStallSeconds - (now - client->getSendQAboveSince())) * 1000UL);
+    }
+}
+
+MemoryUsage Server::getMemoryUsage() const {
+    // 使用中スロット、スロット外のヒープ領域（クラスごとの集計）と未送信データを数える（全クライアントを走査しない）
+    MemoryUsage usage;
+    const PoolStats& clients = _clientPool.getStats();
+    const PoolStats& channels = _channelPool.getStats();
+    const PoolStats& messages = SharedMessage::getPoolStats();
+    usage.clients = clients.inUse * clients.objectSize + Client::getHeapTotal();
+    usage.channels = channels.inUse * channels.objectSize + Channel::getHeapTotal();
+    usage.messages = messages.inUse * messages.objectSize;
+    usage.transfers = 0;
+    if (_dccManager) {
+        const PoolStats& transfers = _dccManager->getPoolStats();
+        usage.transfers = transfers.inUse * transfers.objectSize;
+    }
+    usage.ioUring = _ioUring ? _ioUring->getQueuedBytes() : 0;
+    usage.arena = _arena.getReserved();
+    return usage;
+}
+
+void Server::checkMemoryPressure() {
+    size_t usage = getMemoryUsage().total();
+    if (usage > _memoryStats.peak) {
+        _memoryStats.peak = usage;
+    }
+
+    size_t pauseAt = _memoryStats.budget / 100 * MEMORY_PAUSE_PERCENT;
+    size_t resumeAt = _memoryStats.budget / 100 * MEMORY_RESUME_PERCENT;
+    time_t now = time(NULL);
+
+    if (usage >= pauseAt) {
+        // 逼迫中は1秒ごとに受信停止の対象を追加で選ぶ
+        if (!_memoryStats.underPressure || now != _memoryStats.lastRebalance) {
+            if (!_memoryStats.underPressure) {
+                std::cout << "\033[1;33m[MEMORY] Usage " << usage / 1024 << "KB reached "
+                          << MEMORY_PAUSE_PERCENT << "% of budget " << _memoryStats.budget / 1024
+                          << "KB, pausing reads from the heaviest senders\033[0m" << std::endl;
             }
+            _memoryStats.underPressure = true;
+            _memoryStats.lastRebalance = now;
+            pauseHeaviestSenders();
+        }
+    } else if (_memoryStats.underPressure && usage <= resumeAt) {
+        std::cout << "\033[1;32m[MEMORY] Usage " << usage / 1024 << "KB back under "
+                  << MEMORY_RESUME_PERCENT << "% of budget, resuming reads\033[0m" << std::endl;
+        _memoryStats.underPressure = false;
+        resumePausedClients();
+    }
+
+    // 受信を止めても予算を超えている場合は送信キューの大きいクライアントから切断
+    if (usage > _memoryStats.budget) {
+        shedLargestQueues(usage);
+    }
+}
+
+void Server::pauseHeaviestSenders() {
+    // 直近の受信量が多い順に、接続数のMEMORY_PAUSE_SHARE%（最低1人）の受信を止める
+    // 受信バッファ1つ分も送っていないクライアントは原因ではないので対象にしない
+    std::vector<std::pair<unsigned long, int> > senders;
+    for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        Client* client = it->second;
+        unsigned long score = client->getInputScore();
+        if (score >= RECV_BUFFER_SIZE && !client->isReadPaused() && !client->isDisconnectPending()) {
+            senders.push_back(std::make_pair(score, it->first));
         }
     }
+    if (senders.empty()) {
+        return;
+    }
 
-    // FD の数が変わった場合のみログを出力
-    if (_pollfds.size() != lastPollFDCount) {
-        std::cout << "\033[1;36m[SERVER] Poll array updated: " << _pollfds.size() << " file descriptors monitored\033[0m" << std::endl;
-        lastPollFDCount = _pollfds.size();
+    size_t count = std::max((size_t)1, _clients.size() * MEMORY_PAUSE_SHARE / 100);
+    count = std::min(count, senders.size());
+    std::partial_sort(senders.begin(), senders.begin() + count, senders.end(),
+                      std::greater<std::pair<unsigned long, int> >());
+    for (size_t i = 0; i < count; ++i) {
+        Client* client = getClientByFd(senders[i].second);
+        std::cout << "\033[1;33m[MEMORY] Pausing reads from fd " << senders[i].second
+                  << " (" << senders[i].first << " bytes recently)\033[0m" << std::endl;
+        setReadPaused(client, true);
+    }
+    markStatusDirty();
+}
+
+void Server::resumePausedClients() {
+    for (size_t i = 0; i < _pausedFds.size(); ++i) {
+        // 停止後に切断され、fdが再利用された場合は停止フラグが立っていない
+        Client* client = getClientByFd(_pausedFds[i]);
+        if (client && client->isReadPaused()) {
+            setReadPaused(client, false);
+        }
     }
+    _pausedFds.clear();
+    markStatusDirty();
 }
 
-void Server::removePollFd(int fd) {
-    for (std::vector<struct pollfd>::iterator it = _pollfds.begin(); it != _pollfds.end(); ++it) {
-        if (it->fd == fd) {
-            _pollfds.erase(it);
-            std::cout << "\033[1;36m[SERVER] Removed fd " << fd << " from poll array\033[0m" << std::endl;
+void Server::shedLargestQueues(size_t usage) {
+    // 送信キューの大きい順に、予算内に収まるまで切断する
+    // 切断はこの後の削除でまとめて行うので、既に切断予定のクライアントが解放する分は先に引いておく
+    size_t slotSize = _clientPool.getStats().objectSize;
+    std::vector<std::pair<size_t, int> > queues;
+    for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        if (it->second->isDisconnectPending()) {
+            usage -= std::min(usage, slotSize + it->second->getReleasableMemory());
+        } else {
+            queues.push_back(std::make_pair(it->second->getQueuedOutputSize(), it->first));
+        }
+    }
+    std::sort(queues.begin(), queues.end(), std::greater<std::pair<size_t, int> >());
+
+    for (size_t i = 0; i < queues.size() && usage > _memoryStats.budget; ++i) {
+        if (queues[i].first == 0) {
             break;
         }
+        Client* client = getClientByFd(queues[i].second);
+        // 全体の使用量と同じ単位（スロット + ヒープ）で、この切断で実際に解放される分だけ引く
+        size_t freed = slotSize + client->getReleasableMemory();
+        std::cout << "\033[1;31m[MEMORY] Over budget (" << usage / 1024 << "KB > " << _memoryStats.budget / 1024
+                  << "KB), dropping fd " << queues[i].second << " with " << queues[i].first
+                  << " bytes queued (frees " << freed / 1024 << "KB)\033[0m" << std::endl;
+        client->disconnect("Memory pressure");
+        _memoryStats.sheds++;
+        usage -= std::min(usage, freed);
     }
 }
 
-BotManager* Server::getBotManager() {
-    return _botManager;
+void Server::setReadPaused(Client* client, bool paused) {
+    if (client->isReadPaused() == paused) {
+        return;
+    }
+    client->setReadPaused(paused);
+    if (paused) {
+        _pausedFds.push_back(client->getFd());
+        _memoryStats.pausedClients++;
+        _memoryStats.pauses++;
+    } else {
+        _memoryStats.pausedClients--;
+    }
+
+    // 停止中はソケットから読まない（データはカーネルの受信バッファに留まり、相手の送信が止まる）
+    updateReadInterest(client);
+}
+
+int Server::getFloodBurst() const {
+    return _floodBurst;
+}
+
+int Server::getFloodRate() const {
+    return _floodRate;
+}
+
+void Server::holdClientInput(Client* client, unsigned cost) {
+    _floodStats.deferredLines++;
+    if (client->isFloodHeld()) {
+        return;
+    }
+    std::cout << "\033[1;33m[FLOOD] Holding input from fd " << client->getFd()
+              << " until tokens refill\033[0m" << std::endl;
+    client->holdInput(cost);
+    _floodStats.holds++;
+    _floodStats.heldClients++;
+    updateReadInterest(client);
+}
+
+void Server::scheduleHeldInput(Client* client) {
+    // タイマー処理中にコマンドを実行しないよう、ループで後から処理する
+    _floodReady.push_back(client->getFd());
+}
+
+void Server::resumeHeldInput() {
+    if (_floodReady.empty()) {
+        return;
+    }
+    std::vector<int> ready;
+    ready.swap(_floodReady);
+    for (size_t i = 0; i < ready.size(); ++i) {
+        // 切断後にfdが再利用された場合は保留されていない
+        Client* client = getClientByFd(ready[i]);
+        if (!client || !client->isFloodHeld()) {
+            continue;
+        }
+        client->releaseInput();
+        _floodStats.heldClients--;
+
+        // 受信バッファに残した行と保留中に届いたデータ（io_uring）はスケジューラの順番で処理
+        scheduleClient(client);
+        updateReadInterest(client);
+    }
 }
 
 DCCManager* Server::getDCCManager() {
     return _dccManager;
 }
+
+void Server::watchDCCSocket(int fd, DCCTransfer* transfer) {
+    if (!transfer) {
+        return;
+    }
+
+    if (fd == transfer->getListenSocket()) {
+        // 送信側のリスニングソケット：接続受け入れのみ
+        _reactor.add(fd, FD_DCC_LISTEN, POLLIN, NULL, transfer);
+    } else if (transfer->getType() == DCC_SEND) {
+        // 送信側のデータソケット：送信とACK受信
+        _reactor.add(fd, FD_DCC_DATA, POLLIN | POLLOUT, NULL, transfer);
+    } else {
+        // 受信側のデータソケット：受信のみ
+        _reactor.add(fd, FD_DCC_DATA, POLLIN, NULL, transfer);
+    }
+}
+
+void Server::unwatchFd(int fd) {
+    _reactor.remove(fd);
+}
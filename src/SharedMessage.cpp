@@ -0,0 +1,74 @@
+#include "../include/SharedMessage.hpp"
+
+ObjectPool<SharedMessage::Buffer, 256> SharedMessage::_pool("message");
+
+SharedMessage::SharedMessage() : _buffer(NULL) {
+}
+
+SharedMessage::SharedMessage(const std::string& message)
+    : _buffer(new (_pool.allocate()) Buffer)
+{
+    _buffer->refs = 1;
+    size_t length = message.length();
+
+    // メッセージが長すぎる場合は切り詰める
+    if (length > MAX_MESSAGE_LENGTH) {
+        std::cout << "\033[1;33m[WARNING] Truncating message to 512 characters\033[0m" << std::endl;
+        memcpy(_buffer->data, message.data(), MAX_MESSAGE_LENGTH - 2);
+        memcpy(_buffer->data + MAX_MESSAGE_LENGTH - 2, "\r\n", 2);
+        _buffer->length = MAX_MESSAGE_LENGTH;
+        return;
+    }
+
+    memcpy(_buffer->data, message.data(), length);
+    // 末尾に\r\nがない場合は追加
+    if (message.find("\r\n") == std::string::npos) {
+        memcpy(_buffer->data + length, "\r\n", 2);
+        length += 2;
+    }
+    _buffer->length = length;
+}
+
+SharedMessage::SharedMessage(const SharedMessage& other) : _buffer(other._buffer) {
+    if (_buffer) {
+        _buffer->refs++;
+    }
+}
+
+SharedMessage& SharedMessage::operator=(const SharedMessage& other) {
+    if (_buffer != other._buffer) {
+        release();
+        _buffer = other._buffer;
+        if (_buffer) {
+            _buffer->refs++;
+        }
+    }
+    return *this;
+}
+
+SharedMessage::~SharedMessage() {
+    release();
+}
+
+void SharedMessage::release() {
+    if (_buffer && --_buffer->refs == 0) {
+        _pool.destroy(_buffer);
+    }
+    _buffer = NULL;
+}
+
+const char* SharedMessage::data() const {
+    return _buffer ? _buffer->data : "";
+}
+
+size_t SharedMessage::length() const {
+    return _buffer ? _buffer->length : 0;
+}
+
+bool SharedMessage::isShared() const {
+    return _buffer && _buffer->refs > 1;
+}
+
+const PoolStats& SharedMessage::getPoolStats() {
+    return _pool.getStats();
+}
@@ -0,0 +1,213 @@
+#include "../include/TimerWheel.hpp"
+#include <climits>
+#include <time.h>
+
+Timer::Timer()
+    : _prev(NULL), _next(NULL), _wheel(NULL), _expires(0), _level(0), _slot(0),
+      _handler(NULL), _context(NULL) {
+}
+
+Timer::~Timer() {
+    cancel();
+}
+
+void Timer::setHandler(TimerHandler* handler, void* context) {
+    _handler = handler;
+    _context = context;
+}
+
+void* Timer::getContext() const {
+    return _context;
+}
+
+bool Timer::isScheduled() const {
+    return _wheel != NULL;
+}
+
+void Timer::cancel() {
+    if (_wheel) {
+        _wheel->cancel(*this);
+    }
+}
+
+TimerWheel::TimerWheel() : _currentTick(0), _count(0) {
+    for (int level = 0; level < LEVELS; ++level) {
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            _slots[level][slot] = NULL;
+        }
+    }
+    _baseMs = nowMs();
+}
+
+TimerWheel::~TimerWheel() {
+    // 残っているタイマーを切り離す（所有者側の破棄で二重解除しないように）
+    for (int level = 0; level < LEVELS; ++level) {
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            while (_slots[level][slot]) {
+                cancel(*_slots[level][slot]);
+            }
+        }
+    }
+}
+
+unsigned long long TimerWheel::nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+unsigned long TimerWheel::tickAt(unsigned long long ms) const {
+    if (ms <= _baseMs) {
+        return 0;
+    }
+    return (unsigned long)((ms - _baseMs) / TICK_MS);
+}
+
+void TimerWheel::link(Timer& timer) {
+    // 満了までの距離から階層を決める（範囲外は最上位の末尾に丸める）
+    unsigned long maxDelta = (1UL << (SLOT_BITS * LEVELS)) - 1;
+    if (timer._expires - _currentTick > maxDelta) {
+        timer._expires = _currentTick + maxDelta;
+    }
+    unsigned long delta = timer._expires - _currentTick;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1UL << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = (timer._expires >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+    timer._level = level;
+    timer._slot = slot;
+    timer._prev = NULL;
+    timer._next = _slots[level][slot];
+    if (timer._next) {
+        timer._next->_prev = &timer;
+    }
+    _slots[level][slot] = &timer;
+}
+
+void TimerWheel::unlink(Timer& timer) {
+    if (timer._prev) {
+        timer._prev->_next = timer._next;
+    } else {
+        _slots[timer._level][timer._slot] = timer._next;
+    }
+    if (timer._next) {
+        timer._next->_prev = timer._prev;
+    }
+    timer._prev = NULL;
+    timer._next = NULL;
+}
+
+void TimerWheel::schedule(Timer& timer, unsigned long delayMs) {
+    if (timer._wheel) {
+        timer._wheel->cancel(timer);
+    }
+
+    // 切り上げて、遅くとも指定時間より前には満了させない
+    unsigned long expires = tickAt(nowMs() + delayMs + TICK_MS - 1);
+    if (expires <= _currentTick) {
+        expires = _currentTick + 1;
+    }
+    timer._expires = expires;
+    timer._wheel = this;
+    link(timer);
+    _count++;
+}
+
+void TimerWheel::cancel(Timer& timer) {
+    if (timer._wheel != this) {
+        return;
+    }
+    unlink(timer);
+    timer._wheel = NULL;
+    _count--;
+}
+
+void TimerWheel::cascade(int level) {
+    // 上位階層のスロットを取り出し、残り時間に応じて下位階層へ振り直す
+    int slot = (_currentTick >> (SLOT_BITS * level)) & (SLOTS - 1);
+    Timer* timer = _slots[level][slot];
+    _slots[level][slot] = NULL;
+    while (timer) {
+        Timer* next = timer->_next;
+        link(*timer);
+        timer = next;
+    }
+}
+
+void TimerWheel::advance(unsigned long long now) {
+    unsigned long target = tickAt(now);
+    if (_count == 0) {
+        if (target > _currentTick) {
+            _currentTick = target;
+        }
+        return;
+    }
+
+    while (_currentTick < target) {
+        _currentTick++;
+        for (int level = 1; level < LEVELS; ++level) {
+            if ((_currentTick & ((1UL << (SLOT_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        // 満了したタイマーはリストから外してから呼び出す（ハンドラ内での破棄・再登録に対応）
+        int slot = _currentTick & (SLOTS - 1);
+        while (_slots[0][slot]) {
+            Timer& timer = *_slots[0][slot];
+            cancel(timer);
+            if (timer._handler) {
+                timer._handler->onTimer(timer);
+            }
+        }
+    }
+}
+
+int TimerWheel::nextTimeoutMs(unsigned long long now) const {
+    if (_count == 0) {
+        return -1;
+    }
+
+    // 各階層で次に処理されるスロットのtickを求め、最も早いものを採用
+    unsigned long best = ULONG_MAX;
+    for (int i = 1; i <= SLOTS; ++i) {
+        unsigned long tick = _currentTick + i;
+        if (_slots[0][tick & (SLOTS - 1)]) {
+            best = tick;
+            break;
+        }
+    }
+    for (int level = 1; level < LEVELS; ++level) {
+        int shift = SLOT_BITS * level;
+        for (int i = 1; i <= SLOTS; ++i) {
+            unsigned long tick = ((_currentTick >> shift) + i) << shift;
+            if (_slots[level][(tick >> shift) & (SLOTS - 1)]) {
+                if (tick < best) {
+                    best = tick;
+                }
+                break;
+            }
+        }
+    }
+    if (best == ULONG_MAX) {
+        return -1;
+    }
+
+    unsigned long long deadline = _baseMs + (unsigned long long)best * TICK_MS;
+    if (deadline <= now) {
+        return 0;
+    }
+    unsigned long long remaining = deadline - now;
+    if (remaining > (unsigned long long)INT_MAX) {
+        return INT_MAX;
+    }
+    return (int)remaining;
+}
+
+size_t TimerWheel::size() const {
+    return _count;
+}
@@ -176,4 +176,21 @@ namespace Utils {
 
         return ss.str();
     }
-}
\ No newline at end of file
+
+    // 環境変数から整数設定を読み込む（未設定・不正・範囲外の場合はデフォルト値）
+    int getEnvInt(const char* name, int defaultValue, int minValue, int maxValue) {
+        const char* value = getenv(name);
+        if (!value || *value == '\0') {
+            return defaultValue;
+        }
+
+        char* end = NULL;
+        long parsed = strtol(value, &end, 10);
+        if (*end != '\0' || parsed < minValue || parsed > maxValue) {
+            std::cerr << "\033[1;33m[WARNING] Invalid " << name << "=" << value
+                      << " (expected " << minValue << "-" << maxValue << "), using " << defaultValue << "\033[0m" << std::endl;
+            return defaultValue;
+        }
+        return (int)parsed;
+    }
+}
@@ -0,0 +1,120 @@
+#include "../include/WhoQuery.hpp"
+#include "../include/Server.hpp"
+
+WhoQuery::WhoQuery(Client* requester, const std::string& mask, bool operOnly)
+    : _fd(requester->getFd()), _requester(requester), _mask(mask), _operOnly(operOnly),
+      _fullForm(false), _started(false)
+{
+    // nick!user@host 形式なら各部分を別々に照合（省略した部分は '*'）
+    size_t bang = mask.find('!');
+    size_t at = mask.find('@', bang == std::string::npos ? 0 : bang);
+    if (bang != std::string::npos || at != std::string::npos) {
+        _fullForm = true;
+        size_t nickEnd = (bang != std::string::npos) ? bang : at;
+        std::string nick = mask.substr(0, nickEnd);
+        std::string user = "*";
+        std::string host = "*";
+        if (bang != std::string::npos) {
+            user = mask.substr(bang + 1, at == std::string::npos ? std::string::npos : at - bang - 1);
+        }
+        if (at != std::string::npos) {
+            host = mask.substr(at + 1);
+        }
+        _nick.compile(nick.empty() ? "*" : nick);
+        _user.compile(user.empty() ? "*" : user);
+        _host.compile(host.empty() ? "*" : host);
+    } else {
+        _nick.compile(mask);
+    }
+}
+
+int WhoQuery::getFd() const {
+    return _fd;
+}
+
+Client* WhoQuery::getRequester() const {
+    return _requester;
+}
+
+bool WhoQuery::matches(const Client* target) const {
+    if (target->getStatus() != REGISTERED) {
+        return false;
+    }
+    if (_operOnly && !target->isOperator()) {
+        return false;
+    }
+    if (!_nick.matches(target->getNickname())) {
+        return false;
+    }
+    if (_fullForm) {
+        return _user.matches(target->getUsername()) && _host.matches(target->getHostname());
+    }
+    return true;
+}
+
+bool WhoQuery::run(Server* server, size_t& budget) {
+    // ワイルドカードなしのニックネームは索引で1件だけ引く
+    if (!_fullForm && !_nick.hasWildcard()) {
+        Client* target = server->getClientByNickname(_mask);
+        if (budget > 0) {
+            budget--;
+        }
+        if (target && matches(target)) {
+            sendReply(server, _requester, target, "", "");
+        }
+        _requester->sendNumericReply(RPL_ENDOFWHO, _mask + " :End of WHO list");
+        return true;
+    }
+
+    // ニックネーム順の索引を、マスクのリテラル部分で始まる範囲だけ走査する
+    const NickOrder& order = server->getNickOrder();
+    const std::string& prefix = _nick.getPrefix();
+    NickOrder::const_iterator it = _started ? order.upper_bound(_cursor) : order.lower_bound(prefix);
+    _started = true;
+
+    for (; it != order.end(); ++it) {
+        if (it->first.compare(0, prefix.length(), prefix) != 0) {
+            break;
+        }
+        if (budget == 0) {
+            return false;
+        }
+        budget--;
+        _cursor = it->first;
+        if (matches(it->second)) {
+            sendReply(server, _requester, it->second, "", "");
+        }
+    }
+
+    _requester->sendNumericReply(RPL_ENDOFWHO, _mask + " :End of WHO list");
+    return true;
+}
+
+void WhoQuery::sendReply(Server* server, Client* requester, const Client* target,
+                         const std::string& channelName, const std::string& memberPrefix) {
+    std::string channel = channelName;
+    std::string prefix = memberPrefix;
+
+    // チャンネルが指定されていなければ、参加中の最初のチャンネルを表示（なければ '*'）
+    if (channel.empty()) {
+        channel = "*";
+        const std::vector<NameId>& channels = target->getChannels();
+        if (!channels.empty()) {
+            Channel* first = server->getChannel(channels[0]);
+            if (first) {
+                channel = first->getName();
+                prefix = first->getMemberPrefix(target);
+            }
+        }
+    }
+
+    std::string flags = target->isAway() ? "G" : "H"; // Gone (away) / Here
+    if (target->isOperator()) {
+        flags += "*"; // Server operator
+    }
+    flags += prefix; // @: Channel operator, +: Voice
+
+    // <channel> <user> <host> <server> <nick> <H|G>[*][@|+] :<hopcount> <real name>
+    requester->sendNumericReply(RPL_WHOREPLY, channel + " " + target->getUsername() + " " + target->getHostname() + " " +
+                                server->getHostname() + " " + target->getNickname() + " " + flags + " :0 " + target->getRealname());
+}
@@ -0,0 +1,93 @@
+#include "../include/WildcardMask.hpp"
+#include "../include/NameTable.hpp"
+
+WildcardMask::WildcardMask() : _minLength(0), _hasWildcard(false) {
+}
+
+WildcardMask::WildcardMask(const std::string& mask) : _minLength(0), _hasWildcard(false) {
+    compile(mask);
+}
+
+void WildcardMask::compile(const std::string& mask) {
+    _pattern.clear();
+    _pattern.reserve(mask.length());
+    _prefix.clear();
+    _suffix.clear();
+    _minLength = 0;
+    _hasWildcard = false;
+
+    for (size_t i = 0; i < mask.length(); ++i) {
+        char c = NameTable::foldChar(mask[i]);
+        if (c == '*') {
+            if (!_pattern.empty() && _pattern[_pattern.length() - 1] == '*') {
+                continue;
+            }
+        } else {
+            _minLength++;
+        }
+        if (c == '*' || c == '?') {
+            _hasWildcard = true;
+        } else if (!_hasWildcard) {
+            _prefix += c;
+        }
+        _pattern += c;
+    }
+
+    size_t lastWildcard = _pattern.find_last_of("*?");
+    _suffix = (lastWildcard == std::string::npos) ? _pattern : _pattern.substr(lastWildcard + 1);
+}
+
+bool WildcardMask::matches(const std::string& text) const {
+    if (text.length() < _minLength) {
+        return false;
+    }
+
+    // 直前の'*'の位置まで戻って1文字ずつずらす（最悪でも O(n*m)、通常は線形）
+    size_t p = 0;
+    size_t t = 0;
+    size_t starPattern = std::string::npos;
+    size_t starText = 0;
+
+    while (t < text.length()) {
+        if (p < _pattern.length() && _pattern[p] == '*') {
+            starPattern = p++;
+            starText = t;
+        } else if (p < _pattern.length() && (_pattern[p] == '?' || _pattern[p] == NameTable::foldChar(text[t]))) {
+            p++;
+            t++;
+        } else if (starPattern != std::string::npos) {
+            p = starPattern + 1;
+            t = ++starText;
+        } else {
+            return false;
+        }
+    }
+    while (p < _pattern.length() && _pattern[p] == '*') {
+        p++;
+    }
+    return p == _pattern.length();
+}
+
+const std::string& WildcardMask::getPattern() const {
+    return _pattern;
+}
+
+const std::string& WildcardMask::getPrefix() const {
+    return _prefix;
+}
+
+const std::string& WildcardMask::getSuffix() const {
+    return _suffix;
+}
+
+bool WildcardMask::hasWildcard() const {
+    return _hasWildcard;
+}
+
+size_t WildcardMask::getMemoryUsage() const {
+    return _pattern.capacity() + _prefix.capacity() + _suffix.capacity();
+}
+
+bool WildcardMask::matchesEverything() const {
+    return _pattern == "*";
+}
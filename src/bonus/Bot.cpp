@@ -81,10 +81,8 @@ void Bot::sendMessage(const std::string& target, const std::string& message) {
     if (target[0] == '#' || target[0] == '&') {
         Channel* channel = _server->getChannel(target);
         if (channel) {
-            std::vector<Client*> members = channel->getClients();
-            for (std::vector<Client*>::iterator it = members.begin(); it != members.end(); ++it) {
-                (*it)->sendMessage(formatted);
-            }
+            // 1回だけ整形して全メンバーで共有
+            channel->broadcastMessage(formatted);
         }
     }
     // ターゲットがユーザーの場合
@@ -142,10 +140,7 @@ void Bot::joinChannel(const std::string& channel) {
         // チャンネルメンバーに参加通知を送信
         std::string botPrefix = _nickname + "!" + _username + "@" + _server->getHostname();
         std::string joinMsg = ":" + botPrefix + " JOIN " + channel;
-        std::vector<Client*> members = ch->getClients();
-        for (std::vector<Client*>::iterator it = members.begin(); it != members.end(); ++it) {
-            (*it)->sendMessage(joinMsg);
-        }
+        ch->broadcastMessage(joinMsg);
     }
 }
 
@@ -170,10 +165,7 @@ void Bot::partChannel(const std::string& channel) {
     if (ch) {
         std::string botPrefix = _nickname + "!" + _username + "@" + _server->getHostname();
         std::string partMsg = ":" + botPrefix + " PART " + channel + " :Leaving";
-        std::vector<Client*> members = ch->getClients();
-        for (std::vector<Client*>::iterator it = members.begin(); it != members.end(); ++it) {
-            (*it)->sendMessage(partMsg);
-        }
+        ch->broadcastMessage(partMsg);
     }
 }
 
@@ -194,10 +186,8 @@ void Bot::sendNotice(const std::string& target, const std::string& message) {
     if (target[0] == '#' || target[0] == '&') {
         Channel* channel = _server->getChannel(target);
         if (channel) {
-            std::vector<Client*> members = channel->getClients();
-            for (std::vector<Client*>::iterator it = members.begin(); it != members.end(); ++it) {
-                (*it)->sendMessage(formatted);
-            }
+            // 1回だけ整形して全メンバーで共有
+            channel->broadcastMessage(formatted);
         }
     }
     // ターゲットがユーザーの場合
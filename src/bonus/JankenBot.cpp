@@ -26,6 +26,10 @@ JankenBot::JankenBot(Server* server)
  * @brief JankenBotのデストラクタ
  */
 JankenBot::~JankenBot() {
+    for (std::map<std::string, Timer*>::iterator it = _gameTimers.begin(); it != _gameTimers.end(); ++it) {
+        delete it->second;
+    }
+    _gameTimers.clear();
     _games.clear();
     _stats.clear();
 }
@@ -263,6 +267,7 @@ void JankenBot::startNewGame(Client* player) {
     }
     
     _games[nickname] = game;
+    scheduleGameExpiry(nickname);
     
     sendPrivateMessage(player, "=== 🎮 Rock-Paper-Scissors Game Started! ===");
     sendPrivateMessage(player, "Current Score - You: " + Utils::toString(game.playerScore) + " | Bot: " + Utils::toString(game.botScore));
@@ -395,6 +400,7 @@ void JankenBot::resetGame(Client* player) {
         sendPrivateMessage(player, "Game reset! Final Score - You: " + Utils::toString(it->second.playerScore) + 
                                     " | Bot: " + Utils::toString(it->second.botScore));
         _games.erase(it);
+        removeGameTimer(nickname);
     }
     else {
         sendPrivateMessage(player, "No game in progress.");
@@ -404,21 +410,51 @@ void JankenBot::resetGame(Client* player) {
 }
 
 /**
- * @brief 非アクティブなゲームをクリーンアップ
+ * @brief ゲームの期限タイマーを登録（登録済みなら何もしない）
+ * @param nickname プレイヤーのニックネーム
  */
-void JankenBot::cleanupInactiveGames() {
+void JankenBot::scheduleGameExpiry(const std::string& nickname) {
+    if (_gameTimers.find(nickname) != _gameTimers.end())
+        return;
+    
+    // コンテキストにはマップのキー（ノードが残る間は有効）を渡す
+    std::map<std::string, Timer*>::iterator it = _gameTimers.insert(std::make_pair(nickname, new Timer())).first;
+    it->second->setHandler(this, const_cast<std::string*>(&it->first));
+    _server->getTimers().schedule(*it->second, GAME_TIMEOUT * 1000UL);
+}
+
+/**
+ * @brief ゲームの期限タイマーを削除
+ * @param nickname プレイヤーのニックネーム
+ */
+void JankenBot::removeGameTimer(const std::string& nickname) {
+    std::map<std::string, Timer*>::iterator it = _gameTimers.find(nickname);
+    if (it != _gameTimers.end()) {
+        delete it->second;
+        _gameTimers.erase(it);
+    }
+}
+
+/**
+ * @brief ゲーム期限の満了処理（5分以上アクティビティがない場合は削除）
+ * @param timer 満了したタイマー
+ */
+void JankenBot::onTimer(Timer& timer) {
+    std::string nickname = *static_cast<std::string*>(timer.getContext());
+    std::map<std::string, JankenGame>::iterator it = _games.find(nickname);
+    if (it == _games.end()) {
+        removeGameTimer(nickname);
+        return;
+    }
+    
+    time_t deadline = it->second.lastActivity + GAME_TIMEOUT;
     time_t now = std::time(NULL);
-    std::map<std::string, JankenGame>::iterator it = _games.begin();
-    
-    while (it != _games.end()) {
-        // 5分以上アクティビティがない場合は削除
-        if (now - it->second.lastActivity > 300) {
-            std::map<std::string, JankenGame>::iterator toErase = it;
-            ++it;
-            _games.erase(toErase);
-        }
-        else {
-            ++it;
-        }
+    if (now < deadline) {
+        _server->getTimers().schedule(timer, (deadline - now) * 1000UL);
+        return;
     }
+    
+    std::cout << "\033[1;33m[JANKEN] Game of " << nickname << " expired\033[0m" << std::endl;
+    _games.erase(it);
+    removeGameTimer(nickname);
 }
@@ -2,7 +2,7 @@
 #include "../../include/Server.hpp"
 
 // PASS コマンド
-PassCommand::PassCommand(Server* server, Client* client, const std::vector<std::string>& params)
+PassCommand::PassCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "PASS", params)
 {
     _requiresRegistration = false;
@@ -57,7 +57,7 @@ void PassCommand::execute() {
 }
 
 // NICK コマンド
-NickCommand::NickCommand(Server* server, Client* client, const std::vector<std::string>& params)
+NickCommand::NickCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "NICK", params)
 {
     _requiresRegistration = false;
@@ -98,8 +98,8 @@ void NickCommand::execute() {
     std::string oldNick = _client->getNickname();
 
     // ニックネームが既に使用されている場合はエラー
-    // 自分自身のニックネームへの変更は許可
-    if (_server->isNicknameInUse(nickname) && nickname != oldNick) {
+    // 自分自身のニックネームへの変更（大文字小文字のみの変更を含む）は許可
+    if (_server->isNicknameInUse(nickname) && _server->getClientByNickname(nickname) != _client) {
         _client->sendNumericReply(ERR_NICKNAMEINUSE, nickname + " :Nickname is already in use");
         std::cout << "\033[1;31m[ERROR] Nickname " << nickname << " is already in use\033[0m" << std::endl;
         return;
@@ -111,7 +111,7 @@ void NickCommand::execute() {
     _client->setNickname(nickname);
 
     // サーバーのニックネームマップを更新 - 必ずupdateNicknameメソッドを使用
-    _server->updateNickname(oldNick, nickname);
+    _server->updateNickname(_client, nickname);
 
     // 古いニックネームがある場合は変更通知を送信
     if (!oldNick.empty()) {
@@ -137,7 +137,7 @@ void NickCommand::execute() {
 }
 
 // USER コマンド
-UserCommand::UserCommand(Server* server, Client* client, const std::vector<std::string>& params)
+UserCommand::UserCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "USER", params)
 {
     _requiresRegistration = false;
@@ -3,7 +3,7 @@
 #include "../../include/bonus/BotManager.hpp"
 
 // JOIN コマンド
-JoinCommand::JoinCommand(Server* server, Client* client, const std::vector<std::string>& params)
+JoinCommand::JoinCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "JOIN", params)
 {
 }
@@ -24,10 +24,11 @@ void JoinCommand::execute() {
     }
 
     // 特殊なケース: JOIN 0
-    if (_params[0] == "0") {
+    if (_params.equals(0, "0")) {
         // すべてのチャンネルから退出
-        std::vector<std::string> channels = _client->getChannels();
-        for (std::vector<std::string>::iterator it = channels.begin(); it != channels.end(); ++it) {
+        // 退出でクライアント側の一覧が変わるためコピーして回す
+        std::vector<NameId> channels = _client->getChannels();
+        for (std::vector<NameId>::iterator it = channels.begin(); it != channels.end(); ++it) {
             Channel* channel = _server->getChannel(*it);
             if (channel) {
                 std::string partMessage = ":" + _client->getPrefix() + " PART " + channel->getName() + " :Left all channels";
@@ -89,15 +90,18 @@ void JoinCommand::execute() {
 
             if (!joined) {
                 // 参加失敗の理由を送信
-                if (channel->hasKey() && (key.empty() || key != channel->getKey())) {
+                if (channel->isBanned(_client)) {
+                    _client->sendNumericReply(ERR_BANNEDFROMCHAN, channelName + " :Cannot join channel (+b)");
+                } else if (channel->hasKey() && (key.empty() || key != channel->getKey())) {
                     _client->sendNumericReply(ERR_BADCHANNELKEY, channelName + " :Cannot join channel (+k)");
-                } else if (channel->isInviteOnly() && !channel->isInvited(_client->getNickname())) {
+                } else if (channel->isInviteOnly() && !channel->canJoinWithoutInvite(_client)) {
                     _client->sendNumericReply(ERR_INVITEONLYCHAN, channelName + " :Cannot join channel (+i)");
                 } else if (channel->hasUserLimit() && channel->getClientCount() >= channel->getUserLimit()) {
                     _client->sendNumericReply(ERR_CHANNELISFULL, channelName + " :Cannot join channel (+l)");
                 }
             } else {
-                // 参加メッセージをブロードキャスト
+                // 参加メッセージをブロードキャスト（名前は大文字小文字を含めて既存チャンネルの表記に合わせる）
+                channelName = channel->getName();
                 std::string joinMessage = ":" + _client->getPrefix() + " JOIN " + channelName;
                 
                 // Botに通知
@@ -122,7 +126,7 @@ void JoinCommand::execute() {
 }
 
 // PART コマンド
-PartCommand::PartCommand(Server* server, Client* client, const std::vector<std::string>& params)
+PartCommand::PartCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "PART", params)
 {
 }
@@ -183,12 +187,7 @@ void PartCommand::execute() {
         // 退出メッセージをブロードキャスト
         channel->broadcastMessage(fullPartMessage);
 
-        // クライアントをチャンネルから削除
+        // クライアントをチャンネルから削除（空になった場合はチャンネルも破棄される）
         channel->removeClient(_client);
-
-        // チャンネルが空になった場合は削除
-        if (channel->getClientCount() == 0) {
-            _server->removeChannel(channelName);
-        }
     }
 }
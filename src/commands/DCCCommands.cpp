@@ -8,7 +8,7 @@
 #include <unistd.h>
 
 // DCC SEND コマンドの実装
-DCCSendCommand::DCCSendCommand(Server* server, Client* client, const std::vector<std::string>& params)
+DCCSendCommand::DCCSendCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "DCC", params) {
     _requiresRegistration = true;
 }
@@ -135,7 +135,7 @@ std::string DCCSendCommand::convertIPToLong(const std::string& ip) const {
 }
 
 // DCC GET/ACCEPT コマンドの実装
-DCCGetCommand::DCCGetCommand(Server* server, Client* client, const std::vector<std::string>& params)
+DCCGetCommand::DCCGetCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "DCC", params) {
     _requiresRegistration = true;
 }
@@ -225,7 +225,7 @@ bool DCCGetCommand::parseTransferInfo(const std::string& info, std::string& tran
 }
 
 // DCC REJECT コマンドの実装
-DCCRejectCommand::DCCRejectCommand(Server* server, Client* client, const std::vector<std::string>& params)
+DCCRejectCommand::DCCRejectCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "DCC", params) {
     _requiresRegistration = true;
 }
@@ -264,7 +264,7 @@ void DCCRejectCommand::execute() {
 }
 
 // DCC LIST コマンドの実装
-DCCListCommand::DCCListCommand(Server* server, Client* client, const std::vector<std::string>& params)
+DCCListCommand::DCCListCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "DCC", params) {
     _requiresRegistration = true;
 }
@@ -313,7 +313,7 @@ void DCCListCommand::execute() {
 }
 
 // DCC CANCEL コマンドの実装
-DCCCancelCommand::DCCCancelCommand(Server* server, Client* client, const std::vector<std::string>& params)
+DCCCancelCommand::DCCCancelCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "DCC", params) {
     _requiresRegistration = true;
 }
@@ -362,7 +362,7 @@ void DCCCancelCommand::execute() {
 }
 
 // DCC STATUS コマンドの実装
-DCCStatusCommand::DCCStatusCommand(Server* server, Client* client, const std::vector<std::string>& params)
+DCCStatusCommand::DCCStatusCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "DCC", params) {
     _requiresRegistration = true;
 }
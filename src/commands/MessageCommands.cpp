@@ -3,7 +3,7 @@
 #include "../../include/bonus/BotManager.hpp"
 
 // PRIVMSG コマンド
-PrivmsgCommand::PrivmsgCommand(Server* server, Client* client, const std::vector<std::string>& params)
+PrivmsgCommand::PrivmsgCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "PRIVMSG", params)
 {
 }
@@ -58,6 +58,12 @@ void PrivmsgCommand::execute() {
                 continue;
             }
 
+            // BANされている一般メンバーは発言できない（+o/+vは除く）
+            if (!channel->canSpeak(_client)) {
+                _client->sendNumericReply(ERR_CANNOTSENDTOCHAN, currentTarget + " :Cannot send to channel");
+                continue;
+            }
+
             // メッセージを整形
             std::string formattedMessage = ":" + _client->getPrefix() + " PRIVMSG " + currentTarget + " :" + message;
             std::cout << "Broadcasting to channel: " << formattedMessage << std::endl;
@@ -105,7 +111,7 @@ void PrivmsgCommand::execute() {
 }
 
 // NOTICE コマンド
-NoticeCommand::NoticeCommand(Server* server, Client* client, const std::vector<std::string>& params)
+NoticeCommand::NoticeCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "NOTICE", params)
 {
 }
@@ -143,7 +149,7 @@ void NoticeCommand::execute() {
             Channel* channel = _server->getChannel(currentTarget);
 
             // クライアントがチャンネルに参加しているか確認
-            if (!channel->isClientInChannel(_client)) {
+            if (!channel->isClientInChannel(_client) || !channel->canSpeak(_client)) {
                 continue; // NOTICEはエラーを返さない
             }
 
@@ -2,7 +2,7 @@
 #include "../../include/Server.hpp"
 
 // KICK コマンド
-KickCommand::KickCommand(Server* server, Client* client, const std::vector<std::string>& params)
+KickCommand::KickCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "KICK", params)
 {
 }
@@ -45,13 +45,16 @@ void KickCommand::execute() {
     }
 
     // クライアントがチャンネルオペレータかどうか確認
-    if (!channel->isOperator(_client->getNickname())) {
+    if (!channel->isOperator(_client)) {
         _client->sendNumericReply(ERR_CHANOPRIVSNEEDED, channelName + " :You're not channel operator");
         return;
     }
 
+    // ターゲットユーザーを取得
+    Client* targetClient = _server->getClientByNickname(targetNick);
+
     // ターゲットユーザーがチャンネルに参加しているか確認
-    if (!channel->isClientInChannel(targetNick)) {
+    if (!targetClient || !channel->isClientInChannel(targetClient)) {
         _client->sendNumericReply(ERR_USERNOTINCHANNEL, targetNick + " " + channelName + " :They aren't on that channel");
         return;
     }
@@ -64,9 +67,6 @@ void KickCommand::execute() {
         reason = targetNick;
     }
 
-    // ターゲットユーザーを取得
-    Client* targetClient = _server->getClientByNickname(targetNick);
-
     // KICKメッセージをブロードキャスト
     std::string kickMessage = ":" + _client->getPrefix() + " KICK " + channelName + " " + targetNick + " :" + reason;
     channel->broadcastMessage(kickMessage);
@@ -76,7 +76,7 @@ void KickCommand::execute() {
 }
 
 // INVITE コマンド
-InviteCommand::InviteCommand(Server* server, Client* client, const std::vector<std::string>& params)
+InviteCommand::InviteCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "INVITE", params)
 {
 }
@@ -119,7 +119,7 @@ void InviteCommand::execute() {
     }
 
     // 招待制チャンネルの場合はオペレータ権限が必要
-    if (channel->isInviteOnly() && !channel->isOperator(_client->getNickname())) {
+    if (channel->isInviteOnly() && !channel->isOperator(_client)) {
         _client->sendNumericReply(ERR_CHANOPRIVSNEEDED, channelName + " :You're not channel operator");
         return;
     }
@@ -149,7 +149,7 @@ void InviteCommand::execute() {
 }
 
 // TOPIC コマンド
-TopicCommand::TopicCommand(Server* server, Client* client, const std::vector<std::string>& params)
+TopicCommand::TopicCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "TOPIC", params)
 {
 }
@@ -204,7 +204,7 @@ void TopicCommand::execute() {
     std::string newTopic = _params[1];
 
     // トピックが制限されている場合はオペレータ権限が必要
-    if (channel->isTopicRestricted() && !channel->isOperator(_client->getNickname())) {
+    if (channel->isTopicRestricted() && !channel->isOperator(_client)) {
         _client->sendNumericReply(ERR_CHANOPRIVSNEEDED, channelName + " :You're not channel operator");
         return;
     }
@@ -218,7 +218,7 @@ void TopicCommand::execute() {
 }
 
 // MODE コマンド
-ModeCommand::ModeCommand(Server* server, Client* client, const std::vector<std::string>& params)
+ModeCommand::ModeCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "MODE", params)
 {
 }
@@ -256,6 +256,18 @@ void ModeCommand::execute() {
             return;
         }
 
+        // "MODE #chan b"（e/Iも同様）はリストの表示のみなのでオペレータ権限は不要
+        if (_params.size() == 2) {
+            std::string query = _params[1];
+            if (!query.empty() && query[0] == '+') {
+                query.erase(0, 1);
+            }
+            if (query == "b" || query == "e" || query == "I") {
+                channel->sendMaskList(_client, query[0]);
+                return;
+            }
+        }
+
         // クライアントがチャンネルに参加しているか確認
         if (!channel->isClientInChannel(_client)) {
             _client->sendNumericReply(ERR_NOTONCHANNEL, targetName + " :You're not on that channel");
@@ -263,7 +275,7 @@ void ModeCommand::execute() {
         }
 
         // クライアントがチャンネルオペレータかどうか確認
-        if (!channel->isOperator(_client->getNickname())) {
+        if (!channel->isOperator(_client)) {
             _client->sendNumericReply(ERR_CHANOPRIVSNEEDED, targetName + " :You're not channel operator");
             return;
         }
@@ -292,7 +304,7 @@ void ModeCommand::execute() {
                 std::string param = "";
 
                 // パラメータが必要なモードの場合
-                if ((c == 'k' && isAddMode) || c == 'o' || (c == 'l' && isAddMode)) {
+                if ((c == 'k' && isAddMode) || c == 'o' || c == 'v' || (c == 'l' && isAddMode)) {
                     if (paramIndex < _params.size()) {
                         param = _params[paramIndex++];
                     } else {
@@ -301,10 +313,33 @@ void ModeCommand::execute() {
                     }
                 }
 
+                // b/e/Iはパラメータがあれば追加/削除、なければリストを表示
+                // マスクは nick!user@host に正規化し、正規化後の形でブロードキャストする
+                bool isMaskMode = (c == 'b' || c == 'e' || c == 'I');
+                if (isMaskMode) {
+                    if (paramIndex < _params.size()) {
+                        param = MaskList::normalize(_params[paramIndex++]);
+                    } else {
+                        channel->sendMaskList(_client, c);
+                        continue;
+                    }
+                }
+
+                // o/vの対象はニックネームから解決して渡す
+                Client* target = NULL;
+                if (c == 'o' || c == 'v') {
+                    target = _server->getClientByNickname(param);
+                }
+
                 // モードを適用
-                bool success = channel->applyMode(c, isAddMode, param);
+                bool success = channel->applyMode(c, isAddMode, param, _client, target);
 
                 if (!success) {
+                    // o/vの対象が不在の場合はapplyMode側で441を送信済み
+                    // b/e/Iの重複・未登録は無視し、リスト上限はapplyMode側で478を送信済み
+                    if (c == 'o' || c == 'v' || isMaskMode) {
+                        continue;
+                    }
                     _client->sendNumericReply(ERR_UNKNOWNMODE, std::string(1, c) + " :is unknown mode char to me");
                 } else {
                     // モード変更メッセージをブロードキャスト
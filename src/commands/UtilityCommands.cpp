@@ -2,7 +2,7 @@
 #include "../../include/Server.hpp"
 
 // PING コマンド
-PingCommand::PingCommand(Server* server, Client* client, const std::vector<std::string>& params)
+PingCommand::PingCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "PING", params)
 {
     _requiresRegistration = false;
@@ -25,7 +25,7 @@ void PingCommand::execute() {
 }
 
 // PONG コマンド
-PongCommand::PongCommand(Server* server, Client* client, const std::vector<std::string>& params)
+PongCommand::PongCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "PONG", params)
 {
     _requiresRegistration = false;
@@ -36,12 +36,18 @@ PongCommand::~PongCommand() {
 }
 
 void PongCommand::execute() {
-    // PONGコマンドは特に処理しない
+    // サーバーが送ったPINGのトークンと照合してRTTを記録
+    // （PONG <server> :<token> / PONG :<token> のどちらの形式にも対応）
     // クライアントの最終アクティビティ時間は既に更新されている
+    for (size_t i = 0; i < _params.size(); ++i) {
+        if (_client->handlePong(_params[i])) {
+            break;
+        }
+    }
 }
 
 // QUIT コマンド
-QuitCommand::QuitCommand(Server* server, Client* client, const std::vector<std::string>& params)
+QuitCommand::QuitCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "QUIT", params)
 {
     _requiresRegistration = false;
@@ -58,12 +64,12 @@ void QuitCommand::execute() {
         quitMessage = _params[0];
     }
 
-    // 参加しているすべてのチャンネルに退出メッセージを送信
-    std::vector<std::string> channels = _client->getChannels();
-    for (std::vector<std::string>::iterator it = channels.begin(); it != channels.end(); ++it) {
+    // 参加しているすべてのチャンネルに退出メッセージを送信（整形は1回だけ）
+    SharedMessage message(":" + _client->getPrefix() + " QUIT :" + quitMessage);
+    const std::vector<NameId>& channels = _client->getChannels();
+    for (std::vector<NameId>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
         Channel* channel = _server->getChannel(*it);
         if (channel) {
-            std::string message = ":" + _client->getPrefix() + " QUIT :" + quitMessage;
             channel->broadcastMessage(message, _client);
         }
     }
@@ -73,7 +79,7 @@ void QuitCommand::execute() {
 }
 
 // WHO コマンド
-WhoCommand::WhoCommand(Server* server, Client* client, const std::vector<std::string>& params)
+WhoCommand::WhoCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "WHO", params)
 {
 }
@@ -99,66 +105,27 @@ void WhoCommand::execute() {
     if (mask[0] == CHANNEL_PREFIX) {
         if (_server->channelExists(mask)) {
             Channel* channel = _server->getChannel(mask);
-            std::vector<Client*> clients = channel->getClients();
-
-            for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it) {
-                Client* c = *it;
-                std::string flags = "H"; // Here (not away)
-
-                if (c->isAway()) {
-                    flags = "G"; // Gone (away)
-                }
+            const MemberList& members = channel->getMembers();
 
-                if (channel->isOperator(c->getNickname())) {
-                    flags += "@"; // Channel operator
-                }
-
-                // <channel> <user> <host> <server> <nick> <H|G>[*][@|+] :<hopcount> <real name>
-                _client->sendNumericReply(352, mask + " " + c->getUsername() + " " + c->getHostname() + " " +
-                                         _server->getHostname() + " " + c->getNickname() + " " + flags + " :0 " + c->getRealname());
+            for (MemberList::const_iterator it = members.begin(); it != members.end(); ++it) {
+                WhoQuery::sendReply(_server, _client, it->client, channel->getName(), channel->getMemberPrefix(*it));
             }
         }
 
-        _client->sendNumericReply(315, mask + " :End of WHO list");
+        _client->sendNumericReply(RPL_ENDOFWHO, mask + " :End of WHO list");
     }
-    // ユーザー名/ニックネームの場合
+    // ニックネーム/マスクの場合（"0" はすべてのユーザー）
     else {
-        std::map<std::string, Channel*>& channels = _server->getChannels();
-
-        for (std::map<std::string, Channel*>::iterator it = channels.begin(); it != channels.end(); ++it) {
-            Channel* channel = it->second;
-            std::vector<Client*> clients = channel->getClients();
-
-            for (std::vector<Client*>::iterator cit = clients.begin(); cit != clients.end(); ++cit) {
-                Client* c = *cit;
-
-                // マスクに一致するかチェック
-                if (c->getNickname() == mask || c->getUsername() == mask) {
-                    std::string flags = "H"; // Here (not away)
-
-                    if (c->isAway()) {
-                        flags = "G"; // Gone (away)
-                    }
-
-                    if (channel->isOperator(c->getNickname())) {
-                        flags += "@"; // Channel operator
-                    }
-
-                    // <channel> <user> <host> <server> <nick> <H|G>[*][@|+] :<hopcount> <real name>
-                    _client->sendNumericReply(352, channel->getName() + " " + c->getUsername() + " " + c->getHostname() + " " +
-                                             _server->getHostname() + " " + c->getNickname() + " " + flags + " :0 " + c->getRealname());
-
-                    break; // 同じユーザーを複数回表示しないようにする
-                }
-            }
+        if (mask == "0") {
+            mask = "*";
         }
-
-        _client->sendNumericReply(315, mask + " :End of WHO list");
+        bool operOnly = _params.size() > 1 && _params.equals(1, "o");
+        _server->startWhoQuery(WhoQuery(_client, mask, operOnly));
     }
 }
 
 // WHOIS コマンド
-WhoisCommand::WhoisCommand(Server* server, Client* client, const std::vector<std::string>& params)
+WhoisCommand::WhoisCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "WHOIS", params)
 {
 }
@@ -194,12 +161,12 @@ void WhoisCommand::execute() {
 
     // ユーザーが参加しているチャンネル情報を送信
     std::string channels = "";
-    std::vector<std::string> userChannels = targetClient->getChannels();
+    const std::vector<NameId>& userChannels = targetClient->getChannels();
 
-    for (std::vector<std::string>::iterator it = userChannels.begin(); it != userChannels.end(); ++it) {
+    for (std::vector<NameId>::const_iterator it = userChannels.begin(); it != userChannels.end(); ++it) {
         Channel* channel = _server->getChannel(*it);
         if (channel) {
-            if (channel->isOperator(targetNick)) {
+            if (channel->isOperator(targetClient)) {
                 channels += "@" + channel->getName() + " ";
             } else {
                 channels += channel->getName() + " ";
@@ -224,7 +191,7 @@ void WhoisCommand::execute() {
 }
 
 // CAP コマンド
-CapCommand::CapCommand(Server* server, Client* client, const std::vector<std::string>& params)
+CapCommand::CapCommand(Server* server, Client* client, const ParamList& params)
     : Command(server, client, "CAP", params)
 {
     _requiresRegistration = false;